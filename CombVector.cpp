@@ -0,0 +1,92 @@
+#include "CombVector.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+/********************----- CLASS: CombVector -----********************/
+uint32_t const CombVector::NO_VALUE;
+
+CombVector::CombVector()
+{
+}
+
+void CombVector::clear()
+{
+  m_bases.clear();
+  m_checks.clear();
+  m_values.clear();
+}
+
+void CombVector::pack(std::vector<Row> const &i_rows, size_t const i_columnCount)
+{
+  this->clear();
+  m_bases.resize(i_rows.size(), 0);
+
+  /***** Place the densest rows first, each at the first base where it fits *****/
+  std::vector<size_t> order(i_rows.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&i_rows](size_t const i_a, size_t const i_b){return i_rows[i_a].size() > i_rows[i_b].size();});
+
+  std::vector<bool> usedSlots;
+  size_t firstFree=0;
+  for(size_t const rowIndex : order)
+  {
+    Row const &row=i_rows[rowIndex];
+    if(row.empty())
+    {
+      continue;
+    }
+
+    while(firstFree < usedSlots.size() && usedSlots[firstFree])
+    {
+      ++firstFree;
+    }
+
+    size_t base=(firstFree > row.front().first) ? firstFree-row.front().first : 0;
+    for(;; ++base)
+    {
+      bool fits=true;
+      for(Row::const_iterator rit=row.begin(); rit!=row.end() && fits; ++rit)
+      {
+        size_t const slot=base+rit->first;
+        fits = (slot >= usedSlots.size() || !usedSlots[slot]);
+      }
+      if(fits)
+      {
+        break;
+      }
+    }
+
+    m_bases[rowIndex] = uint32_t(base);
+    if(usedSlots.size() < base+i_columnCount)
+    {
+      usedSlots.resize(base+i_columnCount, false);
+      m_checks.resize(base+i_columnCount, NO_VALUE);
+      m_values.resize(base+i_columnCount, NO_VALUE);
+    }
+    for(Row::const_iterator rit=row.begin(); rit!=row.end(); ++rit)
+    {
+      usedSlots[base+rit->first] = true;
+      m_checks[base+rit->first] = uint32_t(rowIndex);
+      m_values[base+rit->first] = rit->second;
+    }
+  }
+
+  /***** Empty rows sit at base 0; pad so any column can be probed *****/
+  if(m_checks.size() < i_columnCount)
+  {
+    m_checks.resize(i_columnCount, NO_VALUE);
+    m_values.resize(i_columnCount, NO_VALUE);
+  }
+}
+
+size_t CombVector::sizeBytes() const
+{
+  return sizeof(CombVector) + (m_bases.capacity()+m_checks.capacity()+m_values.capacity())*sizeof(uint32_t);
+}
+
+size_t CombVector::slotCount() const
+{
+  return m_values.size();
+}
+/**************************************************/
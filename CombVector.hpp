@@ -0,0 +1,50 @@
+#ifndef _COMBVECTOR_HPP_
+#define _COMBVECTOR_HPP_
+
+#include <cstdint>
+#include <stddef.h>
+#include <utility>
+#include <vector>
+
+/********************----- CLASS: CombVector -----********************/
+//Sparse rows packed into one array by row displacement: each row gets a
+//base offset chosen so its entries land in free slots, and a parallel check
+//array records which row owns each slot. Lookups are two loads and a compare.
+class CombVector
+{
+public:
+  typedef std::vector<std::pair<uint32_t, uint32_t>> Row; //(column, value), sorted by column
+
+  static uint32_t const NO_VALUE=UINT32_MAX;
+
+  CombVector();
+
+  void clear();
+  void pack(std::vector<Row> const &i_rows, size_t const i_columnCount);
+
+  uint32_t find(size_t const i_row, size_t const i_column) const;
+  size_t sizeBytes() const;
+  size_t slotCount() const;
+private:
+  std::vector<uint32_t> m_bases;
+  std::vector<uint32_t> m_checks;
+  std::vector<uint32_t> m_values;
+};
+/**************************************************/
+
+/********************----- Inline Functions -----********************/
+//Called for every parser step
+inline uint32_t CombVector::find(size_t const i_row, size_t const i_column) const
+{
+  //Every row is padded to the full column count, so the slot always exists
+  size_t const slot=m_bases[i_row]+i_column;
+  if(m_checks[slot] != i_row)
+  {
+    return NO_VALUE;
+  }
+
+  return m_values[slot];
+}
+/**************************************************/
+
+#endif /* _COMBVECTOR_HPP_ */
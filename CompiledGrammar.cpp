@@ -0,0 +1,318 @@
+#include "CompiledGrammar.hpp"
+
+#include <stdexcept>
+
+/********************----- CLASS: CompiledGrammar -----********************/
+CompiledGrammar::CompiledGrammar(Grammar const &i_grammar, Numbering const i_numbering, LRStats * const io_stats)
+:m_terminalCount(0), m_startSymbol(SYMBOLID_INVALID), m_setWords(0)
+{
+  Grammar const &g=i_grammar;
+  if(!g.isContextFree())
+  {
+    throw std::logic_error("Tried to freeze non-context-free grammar");
+  }
+
+  /***** Number END and EPSILON, the other terminals, then nonterminals *****/
+  //The grammar gives END and EPSILON the same IDs, so GRAMMAR numbering
+  //only differs in leaving the rest where they are
+  std::vector<SymbolId> compiledIds(g.symbolCount(), SYMBOLID_INVALID);
+  compiledIds[Grammar::END_ID] = END_ID;
+  compiledIds[Grammar::EPSILON_ID] = EPSILON_ID;
+  m_symbols.push_back(g.symbol(Grammar::END_ID));
+  m_symbols.push_back(g.symbol(Grammar::EPSILON_ID));
+  for(int nonterminals=0; nonterminals<2; ++nonterminals)
+  {
+    for(SymbolId i=0; i<g.symbolCount(); ++i)
+    {
+      bool const numbered=(i_numbering == Numbering::GRAMMAR) ? (nonterminals == 0) : (g.symbol(i).isNonterminal() == (nonterminals != 0));
+      if(compiledIds[i] == SYMBOLID_INVALID && numbered)
+      {
+        compiledIds[i] = SymbolId(m_symbols.size());
+        m_symbols.push_back(g.symbol(i));
+      }
+    }
+  }
+
+  m_terminals.resize(m_symbols.size());
+  for(SymbolId i=0; i<m_symbols.size(); ++i)
+  {
+    m_terminals[i] = !m_symbols[i].isNonterminal();
+    m_terminalCount += m_terminals[i] ? 1 : 0;
+  }
+
+  m_associativities.resize(m_symbols.size());
+  m_precedences.resize(m_symbols.size());
+  for(SymbolId i=0; i<g.symbolCount(); ++i)
+  {
+    m_symbolIds[g.symbol(i)] = compiledIds[i];
+    m_associativities[compiledIds[i]] = g.associativity(i);
+    m_precedences[compiledIds[i]] = g.precedence(i);
+  }
+  if(g.productionCount() > 0)
+  {
+    m_startSymbol = compiledIds[g.symbolId(g.startSymbol())];
+  }
+
+  /***** Flatten the right sides *****/
+  std::vector<uint32_t> leftCounts(m_symbols.size(), 0);
+  m_rightBegins.push_back(0);
+  for(size_t i=0; i<g.productionCount(); ++i)
+  {
+    SymbolId const left=compiledIds[g.productionLeft(i)];
+    m_productionLefts.push_back(left);
+    ++leftCounts[left];
+    for(SymbolId const rightId : g.productionRight(i))
+    {
+      m_rights.push_back(compiledIds[rightId]);
+    }
+    m_rightBegins.push_back(uint32_t(m_rights.size()));
+    m_productionPrecedences.push_back(g.productionPrecedence(i));
+  }
+
+  /***** Group production indices by left side, in grammar order *****/
+  m_leftBegins.assign(m_symbols.size()+1, 0);
+  for(size_t i=0; i<m_symbols.size(); ++i)
+  {
+    m_leftBegins[i+1] = m_leftBegins[i]+leftCounts[i];
+  }
+  m_leftProductions.resize(m_productionLefts.size());
+  std::vector<uint32_t> nextSlots(m_leftBegins.begin(), m_leftBegins.end()-1);
+  for(size_t i=0; i<m_productionLefts.size(); ++i)
+  {
+    m_leftProductions[nextSlots[m_productionLefts[i]]++] = uint32_t(i);
+  }
+
+  /***** Analysis; nullable is counted as part of FIRST *****/
+  m_setWords = (m_symbols.size()+63)/64;
+  {
+    LRStats::Timer timer(io_stats, LRStats::Phase::FIRST);
+    this->buildNullable();
+    this->buildFirst();
+  }
+  {
+    LRStats::Timer timer(io_stats, LRStats::Phase::FOLLOW);
+    this->buildFollow();
+  }
+}
+
+CompiledGrammar::CompiledGrammar(CompiledGrammar &&i_compiledGrammar)
+:m_symbols(std::move(i_compiledGrammar.m_symbols)), m_symbolIds(std::move(i_compiledGrammar.m_symbolIds)),
+ m_terminals(std::move(i_compiledGrammar.m_terminals)), m_terminalCount(i_compiledGrammar.m_terminalCount), m_startSymbol(i_compiledGrammar.m_startSymbol),
+ m_productionLefts(std::move(i_compiledGrammar.m_productionLefts)), m_rightBegins(std::move(i_compiledGrammar.m_rightBegins)),
+ m_rights(std::move(i_compiledGrammar.m_rights)), m_leftBegins(std::move(i_compiledGrammar.m_leftBegins)),
+ m_leftProductions(std::move(i_compiledGrammar.m_leftProductions)), m_associativities(std::move(i_compiledGrammar.m_associativities)),
+ m_precedences(std::move(i_compiledGrammar.m_precedences)), m_productionPrecedences(std::move(i_compiledGrammar.m_productionPrecedences)),
+ m_setWords(i_compiledGrammar.m_setWords), m_nullable(std::move(i_compiledGrammar.m_nullable)),
+ m_first(std::move(i_compiledGrammar.m_first)), m_follow(std::move(i_compiledGrammar.m_follow))
+{
+}
+
+Grammar::Associativity CompiledGrammar::associativity(SymbolId const i_symbolId) const
+{
+  return m_associativities.at(i_symbolId);
+}
+
+void CompiledGrammar::buildFirst()
+{
+  //A terminal begins only itself; nonterminals gather FIRST of each right
+  //side up to its first symbol that cannot derive the empty string
+  m_first.assign(m_symbols.size()*m_setWords, 0);
+  for(SymbolId i=0; i<m_symbols.size(); ++i)
+  {
+    if(m_terminals[i] && i != EPSILON_ID)
+    {
+      m_first[i*m_setWords + i/64] |= uint64_t(1) << (i%64);
+    }
+  }
+
+  bool changed=true;
+  while(changed)
+  {
+    changed = false;
+    for(size_t i=0; i<m_productionLefts.size(); ++i)
+    {
+      uint64_t * const leftFirst=m_first.data()+m_productionLefts[i]*m_setWords;
+      for(SymbolId const *rit=this->productionRight(i); rit!=this->productionRight(i)+this->productionLength(i); ++rit)
+      {
+        uint64_t const * const rightFirst=this->first(*rit);
+        for(size_t w=0; w<m_setWords; ++w)
+        {
+          uint64_t const merged=leftFirst[w] | rightFirst[w];
+          changed = changed || (merged != leftFirst[w]);
+          leftFirst[w] = merged;
+        }
+
+        if(!m_nullable[*rit])
+        {
+          break;
+        }
+      }
+    }
+  }
+}
+
+void CompiledGrammar::buildFollow()
+{
+  //Walk each right side backwards carrying what may follow the symbol
+  //reached so far: FOLLOW of the left side, then FIRST of what is passed
+  m_follow.assign(m_symbols.size()*m_setWords, 0);
+  if(m_startSymbol != SYMBOLID_INVALID)
+  {
+    m_follow[m_startSymbol*m_setWords + END_ID/64] |= uint64_t(1) << (END_ID%64);
+  }
+
+  std::vector<uint64_t> trailer(m_setWords);
+  bool changed=true;
+  while(changed)
+  {
+    changed = false;
+    for(size_t i=0; i<m_productionLefts.size(); ++i)
+    {
+      uint64_t const * const leftFollow=this->follow(m_productionLefts[i]);
+      trailer.assign(leftFollow, leftFollow+m_setWords);
+
+      for(size_t x=this->productionLength(i); x-- > 0;)
+      {
+        SymbolId const rightId=this->productionRight(i)[x];
+        if(!this->isTerminal(rightId))
+        {
+          uint64_t * const rightFollow=m_follow.data()+rightId*m_setWords;
+          for(size_t w=0; w<m_setWords; ++w)
+          {
+            uint64_t const merged=rightFollow[w] | trailer[w];
+            changed = changed || (merged != rightFollow[w]);
+            rightFollow[w] = merged;
+          }
+        }
+
+        uint64_t const * const rightFirst=this->first(rightId);
+        for(size_t w=0; w<m_setWords; ++w)
+        {
+          trailer[w] = m_nullable[rightId] ? (trailer[w] | rightFirst[w]) : rightFirst[w];
+        }
+      }
+    }
+  }
+}
+
+void CompiledGrammar::buildNullable()
+{
+  m_nullable.assign(m_symbols.size(), false);
+  m_nullable[EPSILON_ID] = true;
+
+  bool changed=true;
+  while(changed)
+  {
+    changed = false;
+    for(size_t i=0; i<m_productionLefts.size(); ++i)
+    {
+      if(m_nullable[m_productionLefts[i]])
+      {
+        continue;
+      }
+
+      bool rightNullable=true;
+      for(SymbolId const *rit=this->productionRight(i); rit!=this->productionRight(i)+this->productionLength(i) && rightNullable; ++rit)
+      {
+        rightNullable = m_nullable[*rit];
+      }
+      if(rightNullable)
+      {
+        m_nullable[m_productionLefts[i]] = true;
+        changed = true;
+      }
+    }
+  }
+}
+
+//ORs FIRST of the symbols from i_begin up to i_end into io_firstBits, and
+//returns whether all of them can derive the empty string
+bool CompiledGrammar::firstList(SymbolId const *i_begin, SymbolId const * const i_end, uint64_t * const io_firstBits) const
+{
+  for(; i_begin!=i_end; ++i_begin)
+  {
+    uint64_t const * const symbolFirst=this->first(*i_begin);
+    for(size_t w=0; w<m_setWords; ++w)
+    {
+      io_firstBits[w] |= symbolFirst[w];
+    }
+
+    if(!m_nullable[*i_begin])
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+size_t CompiledGrammar::precedence(SymbolId const i_symbolId) const
+{
+  return m_precedences.at(i_symbolId);
+}
+
+size_t CompiledGrammar::productionCount() const
+{
+  return m_productionLefts.size();
+}
+
+size_t CompiledGrammar::productionPrecedence(size_t const i_ruleIndex) const
+{
+  return m_productionPrecedences.at(i_ruleIndex);
+}
+
+//Written as Production::toString() writes the grammar's production
+std::string CompiledGrammar::productionString(size_t const i_ruleIndex) const
+{
+  std::string returnString=m_symbols[m_productionLefts[i_ruleIndex]].toString() + " =>";
+  for(size_t x=0; x<this->productionLength(i_ruleIndex); ++x)
+  {
+    returnString += " " + m_symbols[this->productionRight(i_ruleIndex)[x]].toString();
+  }
+
+  return returnString;
+}
+
+size_t CompiledGrammar::setWords() const
+{
+  return m_setWords;
+}
+
+SymbolId CompiledGrammar::startSymbol() const
+{
+  return m_startSymbol;
+}
+
+size_t CompiledGrammar::symbolCount() const
+{
+  return m_symbols.size();
+}
+
+SymbolId CompiledGrammar::symbolId(Symbol const &i_symbol) const
+{
+  std::unordered_map<Symbol, SymbolId>::const_iterator sit=m_symbolIds.find(i_symbol);
+  if(sit == m_symbolIds.end())
+  {
+    return SYMBOLID_INVALID;
+  }
+
+  return sit->second;
+}
+
+size_t CompiledGrammar::terminalCount() const
+{
+  return m_terminalCount;
+}
+
+std::string CompiledGrammar::toString() const
+{
+  std::string returnString;
+
+  for(size_t i=0; i<this->productionCount(); ++i)
+  {
+    returnString += this->productionString(i) + "\n";
+  }
+
+  return returnString;
+}
+/**************************************************/
@@ -0,0 +1,157 @@
+#ifndef _COMPILEDGRAMMAR_HPP_
+#define _COMPILEDGRAMMAR_HPP_
+
+#include "Grammar.hpp"
+#include "LRStats.hpp"
+#include "Symbol.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/********************----- CLASS: CompiledGrammar -----********************/
+//An immutable, indexed copy of a grammar, made by Grammar::freeze(). Symbols
+//are renumbered so terminals come first, right sides are stored back to
+//back, and nullable, FIRST and FOLLOW are computed up front. Nothing is
+//built lazily, so any number of threads may query one at the same time.
+//Productions keep the indices they have in the grammar; GRAMMAR numbering
+//keeps the symbol IDs too, so they stay put as productions are appended,
+//which incrementally updated tables rely on.
+class CompiledGrammar
+{
+public:
+  static SymbolId const END_ID=0;
+  static SymbolId const EPSILON_ID=1;
+
+  enum class Numbering
+  {
+    TERMINALS_FIRST,
+    GRAMMAR,
+  };
+
+  explicit CompiledGrammar(Grammar const &i_grammar, Numbering const i_numbering=Numbering::TERMINALS_FIRST, LRStats * const io_stats=nullptr);
+  CompiledGrammar(CompiledGrammar &&i_compiledGrammar);
+  virtual ~CompiledGrammar(){}
+
+  /***** Symbols: END_ID, EPSILON_ID and the other terminals, then nonterminals, unless numbered as in the grammar *****/
+  bool isTerminal(SymbolId const i_symbolId) const;
+  SymbolId startSymbol() const;
+  Symbol const &symbol(SymbolId const i_symbolId) const;
+  size_t symbolCount() const;
+  SymbolId symbolId(Symbol const &i_symbol) const;
+  size_t terminalCount() const;
+
+  /***** Productions, and the range of them each nonterminal has *****/
+  size_t productionCount() const;
+  SymbolId productionLeft(size_t const i_ruleIndex) const;
+  size_t productionLength(size_t const i_ruleIndex) const;
+  SymbolId const *productionRight(size_t const i_ruleIndex) const;
+  uint32_t const *productionsBegin(SymbolId const i_left) const;
+  uint32_t const *productionsEnd(SymbolId const i_left) const;
+  std::string productionString(size_t const i_ruleIndex) const;
+
+  Grammar::Associativity associativity(SymbolId const i_symbolId) const;
+  size_t precedence(SymbolId const i_symbolId) const;
+  size_t productionPrecedence(size_t const i_ruleIndex) const;
+
+  /***** Sets are bitsets over symbol IDs, setWords() long; epsilon is never in one *****/
+  static bool contains(uint64_t const * const i_set, SymbolId const i_symbolId);
+  uint64_t const *first(SymbolId const i_symbolId) const;
+  bool firstList(SymbolId const *i_begin, SymbolId const * const i_end, uint64_t * const io_firstBits) const;
+  uint64_t const *follow(SymbolId const i_symbolId) const;
+  bool nullable(SymbolId const i_symbolId) const;
+  size_t setWords() const;
+
+  std::string toString() const;
+private:
+  CompiledGrammar(CompiledGrammar const &)=delete;
+  CompiledGrammar &operator =(CompiledGrammar const &)=delete;
+  CompiledGrammar &operator =(CompiledGrammar &&)=delete;
+
+  void buildFirst();
+  void buildFollow();
+  void buildNullable();
+
+  std::vector<Symbol> m_symbols;
+  std::unordered_map<Symbol, SymbolId> m_symbolIds;
+  std::vector<bool> m_terminals;
+  size_t m_terminalCount;
+  SymbolId m_startSymbol;
+
+  /***** Right sides and per-left ranges, each indexed through an offset array one longer than it has entries *****/
+  SymbolIdVector m_productionLefts;
+  std::vector<uint32_t> m_rightBegins;
+  SymbolIdVector m_rights;
+  std::vector<uint32_t> m_leftBegins;
+  std::vector<uint32_t> m_leftProductions;
+
+  std::vector<Grammar::Associativity> m_associativities;
+  std::vector<size_t> m_precedences;
+  std::vector<size_t> m_productionPrecedences;
+
+  size_t m_setWords;
+  std::vector<bool> m_nullable;
+  std::vector<uint64_t> m_first;
+  std::vector<uint64_t> m_follow;
+};
+/**************************************************/
+
+/********************----- Inline Functions -----********************/
+inline bool CompiledGrammar::isTerminal(SymbolId const i_symbolId) const
+{
+  return m_terminals[i_symbolId];
+}
+
+inline Symbol const &CompiledGrammar::symbol(SymbolId const i_symbolId) const
+{
+  return m_symbols[i_symbolId];
+}
+
+inline SymbolId CompiledGrammar::productionLeft(size_t const i_ruleIndex) const
+{
+  return m_productionLefts[i_ruleIndex];
+}
+
+inline size_t CompiledGrammar::productionLength(size_t const i_ruleIndex) const
+{
+  return m_rightBegins[i_ruleIndex+1]-m_rightBegins[i_ruleIndex];
+}
+
+inline SymbolId const *CompiledGrammar::productionRight(size_t const i_ruleIndex) const
+{
+  return m_rights.data()+m_rightBegins[i_ruleIndex];
+}
+
+inline uint32_t const *CompiledGrammar::productionsBegin(SymbolId const i_left) const
+{
+  return m_leftProductions.data()+m_leftBegins[i_left];
+}
+
+inline uint32_t const *CompiledGrammar::productionsEnd(SymbolId const i_left) const
+{
+  return m_leftProductions.data()+m_leftBegins[i_left+1];
+}
+
+inline bool CompiledGrammar::contains(uint64_t const * const i_set, SymbolId const i_symbolId)
+{
+  return ((i_set[i_symbolId/64] >> (i_symbolId%64)) & 1) != 0;
+}
+
+inline uint64_t const *CompiledGrammar::first(SymbolId const i_symbolId) const
+{
+  return m_first.data()+i_symbolId*m_setWords;
+}
+
+inline uint64_t const *CompiledGrammar::follow(SymbolId const i_symbolId) const
+{
+  return m_follow.data()+i_symbolId*m_setWords;
+}
+
+inline bool CompiledGrammar::nullable(SymbolId const i_symbolId) const
+{
+  return m_nullable[i_symbolId];
+}
+/**************************************************/
+
+#endif /* _COMPILEDGRAMMAR_HPP_ */
@@ -1,12 +1,51 @@
 #include "Grammar.hpp"
+#include "CompiledGrammar.hpp"
 #include "global.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+
+/********************----- CLASS: Grammar::Normalization -----********************/
+std::string Grammar::Normalization::toString() const
+{
+  std::string outputString;
+  for(SymbolSet::const_iterator sit=unproductiveSymbols.begin(); sit!=unproductiveSymbols.end(); ++sit)
+  {
+    outputString += "Unproductive symbol: " + sit->toString() + "\n";
+  }
+  for(SymbolSet::const_iterator sit=unreachableSymbols.begin(); sit!=unreachableSymbols.end(); ++sit)
+  {
+    outputString += "Unreachable symbol: " + sit->toString() + "\n";
+  }
+  for(ProductionDeque::const_iterator pit=removedProductions.begin(); pit!=removedProductions.end(); ++pit)
+  {
+    outputString += "Removed production: " + pit->toString() + "\n";
+  }
+  outputString += std::to_string(removedProductions.size()) + " productions removed, " + std::to_string(duplicateProductions) + " of them duplicates\n";
+
+  return outputString;
+}
+/**************************************************/
 
 /********************----- CLASS: Grammar -----********************/
 Grammar::Grammar()
 :m_analysisFlags(AnalysisFlags::DEFAULT),m_cacheFlags(CacheFlags::DEFAULT)
 {
+  this->registerSymbol(END());
+  this->registerSymbol(EPS());
+}
+
+Grammar::Associativity Grammar::associativity(SymbolId const i_symbolId) const
+{
+  size_t const level=this->precedence(i_symbolId);
+  if(level == 0)
+  {
+    return Associativity::NONE;
+  }
+
+  return m_associativities[level-1];
 }
 
 bool Grammar::isContextFree() const
@@ -33,6 +72,22 @@ void Grammar::add(Production &&i_production)
     m_alphabet.insert(right[i]);
   }
 
+  /***** Update IDs *****/
+  SymbolId const leftId=this->registerSymbol(left[0]);
+  for(size_t i=1; i<left.count(); ++i)
+  {
+    this->registerSymbol(left[i]);
+  }
+  SymbolIdVector rightIds;
+  for(size_t i=0; i<right.count(); ++i)
+  {
+    rightIds.push_back(this->registerSymbol(right[i]));
+  }
+  m_productionIndices[leftId].push_back(m_productions.size()-1);
+  m_productionLefts.push_back(leftId);
+  m_productionRights.push_back(std::move(rightIds));
+  m_precedenceSymbols.push_back(SYMBOLID_INVALID);
+
   /***** Update flags *****/
   if(left.count() > 1)
   {
@@ -42,6 +97,25 @@ void Grammar::add(Production &&i_production)
   m_cacheFlags &= ~(CacheFlags::BUILTFIRST|CacheFlags::BUILTFOLLOW);
 }
 
+void Grammar::addPrecedence(Associativity const i_associativity, SymbolList const &i_terminals)
+{
+  m_associativities.push_back(i_associativity);
+  for(size_t i=0; i<i_terminals.count(); ++i)
+  {
+    if(i_terminals[i].isNonterminal())
+    {
+      throw std::invalid_argument("Precedence can only be declared for terminals");
+    }
+
+    SymbolId const terminalId=this->registerSymbol(i_terminals[i]);
+    if(terminalId >= m_precedences.size())
+    {
+      m_precedences.resize(terminalId+1, 0);
+    }
+    m_precedences[terminalId] = m_associativities.size();
+  }
+}
+
 SymbolSet::const_iterator Grammar::alphabetBegin() const
 {
   return m_alphabet.begin();
@@ -201,29 +275,21 @@ SymbolSet Grammar::first(Symbol const &i_symbol, SymbolMap const &i_firstMap)
 
 SymbolSet Grammar::first(Symbol const &i_symbol) const
 {
-  if(!(m_cacheFlags & CacheFlags::BUILTFIRST))
-  {
-    //Order is necessary - buildFirst eventually calls first
-    m_cacheFlags |= CacheFlags::BUILTFIRST;
-    m_cacheFirst = this->buildFirst();
-  }
+  std::lock_guard<std::recursive_mutex> cacheLock(m_cacheMutex);
+  this->refreshFirst();
 
   return Grammar::first(i_symbol, m_cacheFirst);
 }
 
-SymbolSet Grammar::firstList(SymbolList const &i_symbolList) const
+SymbolSet Grammar::firstList(SymbolListView const &i_symbolList) const
 {
-  if(!(m_cacheFlags & CacheFlags::BUILTFIRST))
-  {
-    //Order is necessary - buildFirst eventually calls first
-    m_cacheFlags |= CacheFlags::BUILTFIRST;
-    m_cacheFirst = this->buildFirst();
-  }
+  std::lock_guard<std::recursive_mutex> cacheLock(m_cacheMutex);
+  this->refreshFirst();
 
   return Grammar::firstList(i_symbolList, m_cacheFirst);
 }
 
-SymbolSet Grammar::firstList(SymbolList const &i_symbolList, SymbolMap const &i_firstMap)
+SymbolSet Grammar::firstList(SymbolListView const &i_symbolList, SymbolMap const &i_firstMap)
 {
   SymbolSet ss;
   if(i_symbolList.isEmpty() || (i_symbolList.containsEpsilon() && i_symbolList.count() == 1))
@@ -246,14 +312,11 @@ SymbolSet Grammar::firstList(SymbolList const &i_symbolList, SymbolMap const &i_
         if(symbolListSet.find(EPS()) == symbolListSet.end())
         {
           /***** Remove epsilon - this rule must always have something *****/
-          if(x==i_symbolList.count()-1)
-          {
-            ss.erase(EPS());
-          }
+          ss.erase(EPS());
           break;
         }
       }
-      catch(std::out_of_range)
+      catch(std::out_of_range const &)
       {
 #ifndef NDEBUG
         std::cerr << "FIRST: Symbol '" << symbolListSymbol.toString() << "' has no first entry yet." << std::endl;
@@ -266,7 +329,201 @@ SymbolSet Grammar::firstList(SymbolList const &i_symbolList, SymbolMap const &i_
   return ss;
 }
 
-ProductionConstPtrVector Grammar::productionPointers(SymbolList const &i_left) const
+//Later changes to this grammar do not reach the copy
+CompiledGrammar Grammar::freeze(LRStats * const io_stats) const
+{
+  return CompiledGrammar(*this, CompiledGrammar::Numbering::TERMINALS_FIRST, io_stats);
+}
+
+SymbolSet Grammar::follow(Symbol const &i_symbol) const
+{
+  std::lock_guard<std::recursive_mutex> cacheLock(m_cacheMutex);
+  this->refreshFollow();
+
+  SymbolMap::const_iterator fit=m_cacheFollow.find(i_symbol);
+  if(fit == m_cacheFollow.end())
+  {
+    return SymbolSet();
+  }
+
+  return fit->second;
+}
+
+Grammar::Normalization Grammar::normalize()
+{
+  //Drops productions using a nonterminal that derives no terminal string,
+  //then those unreachable from the start symbol, then repeated ones. Symbol
+  //IDs are renumbered, so tables must be built after this
+  if(!this->isContextFree())
+  {
+    throw std::logic_error("Tried to normalize non-context-free grammar");
+  }
+  if(m_productions.empty())
+  {
+    return Normalization{SymbolSet(), SymbolSet(), ProductionDeque(), 0};
+  }
+
+  /***** Productive symbols: terminals, and nonterminals with an all-productive production *****/
+  std::vector<bool> productiveSymbols(m_symbols.size(), false);
+  for(SymbolId i=0; i<m_symbols.size(); ++i)
+  {
+    productiveSymbols[i] = !m_symbols[i].isNonterminal();
+  }
+
+  bool symbolAdded=true;
+  while(symbolAdded)
+  {
+    symbolAdded = false;
+    for(size_t i=0; i<m_productions.size(); ++i)
+    {
+      SymbolIdVector const &right=m_productionRights[i];
+      if(!productiveSymbols[m_productionLefts[i]] && std::all_of(right.begin(), right.end(), [&productiveSymbols](SymbolId const i_symbolId){return productiveSymbols[i_symbolId];}))
+      {
+        productiveSymbols[m_productionLefts[i]] = true;
+        symbolAdded = true;
+      }
+    }
+  }
+
+  SymbolId const startId=m_productionLefts[0];
+  if(!productiveSymbols[startId])
+  {
+    throw std::logic_error("Start symbol derives no terminal string");
+  }
+
+  std::vector<bool> keptProductions(m_productions.size(), false);
+  for(size_t i=0; i<m_productions.size(); ++i)
+  {
+    SymbolIdVector const &right=m_productionRights[i];
+    keptProductions[i] = productiveSymbols[m_productionLefts[i]] && std::all_of(right.begin(), right.end(), [&productiveSymbols](SymbolId const i_symbolId){return productiveSymbols[i_symbolId];});
+  }
+
+  /***** Reachable symbols, through the productions still kept *****/
+  std::vector<bool> reachableSymbols(m_symbols.size(), false);
+  std::vector<SymbolId> pendingSymbols={startId};
+  reachableSymbols[startId] = true;
+  while(!pendingSymbols.empty())
+  {
+    SymbolId const currentId=pendingSymbols.back();
+    pendingSymbols.pop_back();
+    for(size_t const productionIndex : m_productionIndices[currentId])
+    {
+      if(!keptProductions[productionIndex])
+      {
+        continue;
+      }
+
+      for(SymbolId const rightId : m_productionRights[productionIndex])
+      {
+        if(!reachableSymbols[rightId])
+        {
+          reachableSymbols[rightId] = true;
+          pendingSymbols.push_back(rightId);
+        }
+      }
+    }
+  }
+
+  /***** Collect what stays, in the original order *****/
+  Normalization normalization{SymbolSet(), SymbolSet(), ProductionDeque(), 0};
+  for(SymbolId i=EPSILON_ID+1; i<m_symbols.size(); ++i)
+  {
+    if(!productiveSymbols[i])
+    {
+      normalization.unproductiveSymbols.insert(m_symbols[i]);
+    }
+    else if(!reachableSymbols[i] && m_alphabet.count(m_symbols[i]) != 0)
+    {
+      normalization.unreachableSymbols.insert(m_symbols[i]);
+    }
+  }
+
+  std::set<std::pair<SymbolId, SymbolIdVector>> seenProductions;
+  ProductionDeque productions;
+  std::vector<Symbol> precedenceSymbols;
+  for(size_t i=0; i<m_productions.size(); ++i)
+  {
+    if(!keptProductions[i] || !reachableSymbols[m_productionLefts[i]])
+    {
+      normalization.removedProductions.push_back(m_productions[i]);
+    }
+    else if(!seenProductions.insert(std::make_pair(m_productionLefts[i], m_productionRights[i])).second)
+    {
+      normalization.removedProductions.push_back(m_productions[i]);
+      ++normalization.duplicateProductions;
+    }
+    else
+    {
+      productions.push_back(m_productions[i]);
+      precedenceSymbols.push_back((m_precedenceSymbols[i] != SYMBOLID_INVALID) ? m_symbols[m_precedenceSymbols[i]] : EPS());
+    }
+  }
+  if(normalization.removedProductions.empty())
+  {
+    return normalization;
+  }
+
+  std::vector<std::pair<Symbol, size_t>> precedences;
+  for(SymbolId i=0; i<m_precedences.size(); ++i)
+  {
+    if(m_precedences[i] != 0)
+    {
+      precedences.push_back(std::make_pair(m_symbols[i], m_precedences[i]));
+    }
+  }
+
+  /***** Rebuild from scratch *****/
+  {
+    std::lock_guard<std::recursive_mutex> cacheLock(m_cacheMutex);
+    m_cacheFlags = CacheFlags::DEFAULT;
+    m_cacheFirst.clear();
+    m_cacheFollow.clear();
+  }
+  m_alphabet.clear();
+  m_analysisFlags = AnalysisFlags::DEFAULT;
+  m_productions.clear();
+  m_symbols.clear();
+  m_symbolIds.clear();
+  m_productionIndices.clear();
+  m_productionLefts.clear();
+  m_productionRights.clear();
+  m_precedences.clear();
+  m_precedenceSymbols.clear();
+
+  this->registerSymbol(END());
+  this->registerSymbol(EPS());
+  for(size_t i=0; i<productions.size(); ++i)
+  {
+    this->add(std::move(productions[i]));
+    if(precedenceSymbols[i] != EPS())
+    {
+      m_precedenceSymbols.back() = this->registerSymbol(precedenceSymbols[i]);
+    }
+  }
+  for(std::pair<Symbol, size_t> const &precedence : precedences)
+  {
+    SymbolId const terminalId=this->registerSymbol(precedence.first);
+    if(terminalId >= m_precedences.size())
+    {
+      m_precedences.resize(terminalId+1, 0);
+    }
+    m_precedences[terminalId] = precedence.second;
+  }
+
+  return normalization;
+}
+
+size_t Grammar::precedence(SymbolId const i_symbolId) const
+{
+  if(i_symbolId >= m_precedences.size())
+  {
+    return 0;
+  }
+
+  return m_precedences[i_symbolId];
+}
+
+ProductionConstPtrVector Grammar::productionPointers(SymbolListView const &i_left) const
 {
   ProductionConstPtrVector outputVector;
 
@@ -281,21 +538,88 @@ ProductionConstPtrVector Grammar::productionPointers(SymbolList const &i_left) c
   return outputVector;
 }
 
+std::vector<size_t> const &Grammar::productionIndices(SymbolId const i_left) const
+{
+  return m_productionIndices.at(i_left);
+}
+
+SymbolId Grammar::productionLeft(size_t const i_ruleIndex) const
+{
+  return m_productionLefts.at(i_ruleIndex);
+}
+
+size_t Grammar::productionPrecedence(size_t const i_ruleIndex) const
+{
+  //As in yacc: the terminal set by setPrecedence(), else the last terminal on the right
+  SymbolId const precedenceSymbol=m_precedenceSymbols.at(i_ruleIndex);
+  if(precedenceSymbol != SYMBOLID_INVALID)
+  {
+    return this->precedence(precedenceSymbol);
+  }
+
+  SymbolIdVector const &right=m_productionRights[i_ruleIndex];
+  for(size_t x=right.size(); x-- > 0;)
+  {
+    if(!m_symbols[right[x]].isNonterminal())
+    {
+      return this->precedence(right[x]);
+    }
+  }
+
+  return 0;
+}
+
+SymbolIdVector const &Grammar::productionRight(size_t const i_ruleIndex) const
+{
+  return m_productionRights.at(i_ruleIndex);
+}
+
 size_t Grammar::productionCount() const
 {
   return m_productions.size();
 }
 
+void Grammar::setPrecedence(size_t const i_ruleIndex, Symbol const &i_terminal)
+{
+  if(i_terminal.isNonterminal())
+  {
+    throw std::invalid_argument("Precedence can only be taken from terminals");
+  }
+
+  m_precedenceSymbols.at(i_ruleIndex) = this->registerSymbol(i_terminal);
+}
+
 Symbol const &Grammar::startSymbol() const
 {
   return m_productions.at(0).left()[0];
 }
 
+Symbol const &Grammar::symbol(SymbolId const i_symbolId) const
+{
+  return m_symbols.at(i_symbolId);
+}
+
+size_t Grammar::symbolCount() const
+{
+  return m_symbols.size();
+}
+
+SymbolId Grammar::symbolId(Symbol const &i_symbol) const
+{
+  std::unordered_map<Symbol, SymbolId>::const_iterator sit=m_symbolIds.find(i_symbol);
+  if(sit == m_symbolIds.end())
+  {
+    return SYMBOLID_INVALID;
+  }
+
+  return sit->second;
+}
+
 std::string Grammar::toString() const
 {
   std::string returnString;
 
-  for(ProductionVector::const_iterator pit=m_productions.begin(); pit!=m_productions.end(); ++pit)
+  for(ProductionDeque::const_iterator pit=m_productions.begin(); pit!=m_productions.end(); ++pit)
   {
     returnString += pit->toString();
     returnString += "\n";
@@ -304,6 +628,37 @@ std::string Grammar::toString() const
   return returnString;
 }
 
+void Grammar::refreshFirst() const
+{
+  if(!(m_cacheFlags & CacheFlags::BUILTFIRST))
+  {
+    //Order is necessary - buildFirst eventually calls first
+    m_cacheFlags |= CacheFlags::BUILTFIRST;
+    m_cacheFirst = this->buildFirst();
+  }
+}
+
+void Grammar::refreshFollow() const
+{
+  if(!(m_cacheFlags & CacheFlags::BUILTFOLLOW))
+  {
+    m_cacheFlags |= CacheFlags::BUILTFOLLOW;
+    m_cacheFollow = this->buildFollow();
+  }
+}
+
+SymbolId Grammar::registerSymbol(Symbol const &i_symbol)
+{
+  std::pair<std::unordered_map<Symbol, SymbolId>::iterator, bool> const symbolPair=m_symbolIds.insert(std::make_pair(i_symbol, SymbolId(m_symbols.size())));
+  if(symbolPair.second)
+  {
+    m_symbols.push_back(i_symbol);
+    m_productionIndices.emplace_back();
+  }
+
+  return symbolPair.first->second;
+}
+
 Grammar &Grammar::operator |=(Production &&i_production)
 {
   this->add(std::forward<Production>(i_production));
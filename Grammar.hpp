@@ -4,26 +4,72 @@
 #include "Symbol.hpp"
 #include "Production.hpp"
 
+#include <deque>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
+class CompiledGrammar;
+class LRStats;
+
 /********************----- CLASS: Grammar -----********************/
 class Grammar
 {
 public:
+  static SymbolId const END_ID=0;
+  static SymbolId const EPSILON_ID=1;
+
+  enum class Associativity
+  {
+    NONE,
+    LEFT,
+    NONASSOC,
+    RIGHT,
+  };
+
+  //What normalize() removed
+  struct Normalization
+  {
+    SymbolSet unproductiveSymbols;
+    SymbolSet unreachableSymbols;
+    ProductionDeque removedProductions;
+    size_t duplicateProductions;
+
+    std::string toString() const;
+  };
+
   Grammar();
   virtual ~Grammar(){}
 
   void add(Production &&i_production);
+  CompiledGrammar freeze(LRStats * const io_stats=nullptr) const;
+  Normalization normalize();
+
+  /***** Precedence: each declaration is a level binding tighter than the ones before *****/
+  void addPrecedence(Associativity const i_associativity, SymbolList const &i_terminals);
+  void setPrecedence(size_t const i_ruleIndex, Symbol const &i_terminal);
+  Associativity associativity(SymbolId const i_symbolId) const;
+  size_t precedence(SymbolId const i_symbolId) const;
+  size_t productionPrecedence(size_t const i_ruleIndex) const;
 
   SymbolSet::const_iterator alphabetBegin() const;
   SymbolSet::const_iterator alphabetEnd() const;
   bool isContextFree() const;
-  ProductionConstPtrVector productionPointers(SymbolList const &i_left) const;
+  ProductionConstPtrVector productionPointers(SymbolListView const &i_left) const;
   size_t productionCount() const;
   Symbol const &startSymbol() const;
 
+  /***** Dense IDs: END_ID and EPSILON_ID, then other symbols in order of appearance *****/
+  Symbol const &symbol(SymbolId const i_symbolId) const;
+  size_t symbolCount() const;
+  SymbolId symbolId(Symbol const &i_symbol) const;
+  std::vector<size_t> const &productionIndices(SymbolId const i_left) const;
+  SymbolId productionLeft(size_t const i_ruleIndex) const;
+  SymbolIdVector const &productionRight(size_t const i_ruleIndex) const;
+
   SymbolSet first(Symbol const &i_symbol) const;
-  SymbolSet firstList(SymbolList const &i_symbolList) const;
+  SymbolSet firstList(SymbolListView const &i_symbolList) const;
+  SymbolSet follow(Symbol const &i_symbol) const;
 
   std::string toString() const;
   Grammar &operator |= (Symbol &&i_symbol);
@@ -46,7 +92,7 @@ protected:
   SymbolMap buildFollow() const;
 
   static SymbolSet first(Symbol const &i_symbol, SymbolMap const &i_firstMap);
-  static SymbolSet firstList(SymbolList const &i_symbolList, SymbolMap const &i_firstMap);
+  static SymbolSet firstList(SymbolListView const &i_symbolList, SymbolMap const &i_firstMap);
 
 private:
   Grammar(Grammar const &)=delete;
@@ -54,14 +100,32 @@ private:
   Grammar &operator =(Grammar const &)=delete;
   Grammar &operator =(Grammar &&)=delete;
 
+  void refreshFirst() const;
+  void refreshFollow() const;
+  SymbolId registerSymbol(Symbol const &i_symbol);
+
   SymbolSet m_alphabet;
   AnalysisFlags m_analysisFlags;
 
+  //Guards the lazily built caches so const queries can run from many threads
+  mutable std::recursive_mutex m_cacheMutex;
   mutable CacheFlags m_cacheFlags;
   mutable SymbolMap m_cacheFirst;
   mutable SymbolMap m_cacheFollow;
 
-  ProductionVector m_productions;
+  ProductionDeque m_productions;
+
+  /***** Symbol and production IDs *****/
+  std::deque<Symbol> m_symbols;
+  std::unordered_map<Symbol, SymbolId> m_symbolIds;
+  std::vector<std::vector<size_t>> m_productionIndices;
+  SymbolIdVector m_productionLefts;
+  std::vector<SymbolIdVector> m_productionRights;
+
+  /***** Precedence levels start at 1; 0 means none was declared *****/
+  std::vector<Associativity> m_associativities;
+  std::vector<size_t> m_precedences;
+  SymbolIdVector m_precedenceSymbols;
 };
 /**************************************************/
 
@@ -1,71 +1,43 @@
 #include "LRAction.hpp"
+#include "CompiledGrammar.hpp"
 
-#include <memory>
+#include <stdexcept>
 
 /********************----- CLASS: LRAction -----********************/
-LRAction::LRAction(Production const * const i_production)
-:m_production(i_production),m_state(0),m_type(LRAction::Type::REDUCE)
+LRAction::LRAction(LRAction::Type const i_type, size_t const i_operand)
+:m_value(Word((Word(enum_value(i_type)) << OPERAND_BITS) | (i_operand & OPERAND_MASK)))
 {
-  if(m_production == nullptr)
+  if(i_operand > OPERAND_MASK)
   {
-    throw std::bad_weak_ptr();
+    throw std::length_error("Operand out of range for LRAction: " + std::to_string(i_operand));
   }
 }
 
-LRAction::LRAction(LRState const i_state)
-:m_production(nullptr),m_state(i_state),m_type(LRAction::Type::SHIFT)
+void LRAction::checkLimits(CompiledGrammar const &i_grammar)
 {
-}
-
-LRAction::LRAction(LRAction::Type const i_type)
-:m_production(nullptr),m_state(0),m_type(i_type)
-{
-}
-
-bool LRAction::isAccept() const
-{
-  return (m_type == LRAction::Type::ACCEPT);
-}
-
-bool LRAction::isReduce() const
-{
-  return (m_type == LRAction::Type::REDUCE);
-}
-
-bool LRAction::isShift() const
-{
-  return (m_type == LRAction::Type::SHIFT);
-}
-
-Production const &LRAction::production() const
-{
-  if(m_production == nullptr)
+  if(i_grammar.productionCount() > size_t(OPERAND_MASK)+1)
   {
-    throw std::bad_weak_ptr();
+    throw std::length_error("Too many productions for LRAction");
   }
-
-  return (*m_production);
-}
-
-LRState const &LRAction::state() const
-{
-  return m_state;
 }
 
 std::string LRAction::toString() const
 {
   std::string outputString;
 
-  switch(m_type)
+  switch(this->type())
   {
     case LRAction::Type::ACCEPT:
       outputString += "ACCEPT()";
       break;
+    case LRAction::Type::ERROR:
+      outputString += "ERROR()";
+      break;
     case LRAction::Type::REDUCE:
-      outputString += "REDUCE(" + m_production->toString() + ")";
+      outputString += "REDUCE(" + std::to_string(this->productionIndex()) + ")";
       break;
     case LRAction::Type::SHIFT:
-      outputString += "SHIFT(" + std::to_string(m_state) + ")";
+      outputString += "SHIFT(" + std::to_string(this->state()) + ")";
       break;
     default:
       throw std::logic_error("Unknown type");
@@ -74,24 +46,14 @@ std::string LRAction::toString() const
   return outputString;
 }
 
-bool LRAction::operator==(LRAction const &i_otherAction) const
+std::string LRAction::toString(CompiledGrammar const &i_grammar) const
 {
-  if(m_type != i_otherAction.m_type)
-  {
-    return false;
-  }
-
-  if(m_state != i_otherAction.m_state)
+  if(this->isReduce())
   {
-    return false;
+    return "REDUCE(" + i_grammar.productionString(this->productionIndex()) + ")";
   }
 
-  if(m_production != i_otherAction.m_production)
-  {
-    return false;
-  }
-
-  return true;
+  return this->toString();
 }
 /**************************************************/
 
@@ -101,14 +63,18 @@ LRAction ACCEPT()
   return LRAction(LRAction::Type::ACCEPT);
 }
 
-LRAction REDUCE(Production const * const i_production)
+LRAction ERROR()
 {
-  return LRAction(i_production);
+  return LRAction(LRAction::Type::ERROR);
+}
+
+LRAction REDUCE(size_t const i_productionIndex)
+{
+  return LRAction(LRAction::Type::REDUCE, i_productionIndex);
 }
 
 LRAction SHIFT(LRState const i_state)
 {
-  return LRAction(i_state);
+  return LRAction(LRAction::Type::SHIFT, i_state);
 }
 /**************************************************/
-
@@ -2,48 +2,79 @@
 #define _LRACTION_HPP_
 
 #include "LRState.hpp"
-#include "Production.hpp"
+#include "global.hpp"
 
+#include <cstdint>
 #include <set>
+#include <string>
+
+class CompiledGrammar;
+
+//Width of an encoded action; 16 halves the tables of grammars with fewer
+//than 16384 states and productions
+#ifndef LR_ACTION_BITS
+#define LR_ACTION_BITS 32
+#endif
 
 /********************----- CLASS: LRAction -----********************/
+//An action packed into one word: the type in the top two bits, and below
+//it the state to shift to or the index of the production to reduce by.
+//Productions are referred to by their index in the grammar.
 class LRAction
 {
   friend LRAction ACCEPT();
-  friend LRAction REDUCE(Production const * const i_production);
+  friend LRAction ERROR();
+  friend LRAction REDUCE(size_t const i_productionIndex);
   friend LRAction SHIFT(LRState const i_state);
 public:
   enum class Type
   {
     ACCEPT,
+    ERROR,
     REDUCE,
     SHIFT
   };
 
+#if LR_ACTION_BITS == 16
+  typedef uint16_t Word;
+#elif LR_ACTION_BITS == 32
+  typedef uint32_t Word;
+#else
+#error "LR_ACTION_BITS must be 16 or 32"
+#endif
+  static unsigned const OPERAND_BITS=LR_ACTION_BITS-2;
+
+  static void checkLimits(CompiledGrammar const &i_grammar);
+
   bool isAccept() const;
+  bool isError() const;
   bool isReduce() const;
   bool isShift() const;
 
-  Production const &production() const;
-  LRState const &state() const;
+  uint32_t productionIndex() const;
+  LRState state() const;
+  Type type() const;
+  Word value() const;
 
   std::string toString() const;
+  std::string toString(CompiledGrammar const &i_grammar) const;
+  bool operator <(LRAction const &i_otherAction) const;
   bool operator==(LRAction const &i_otherAction) const;
+  bool operator!=(LRAction const &i_otherAction) const;
 protected:
-  LRAction(Production const * const i_production);
-  LRAction(LRState const i_state);
-  LRAction(Type const i_type);
+  LRAction(Type const i_type, size_t const i_operand=0);
 
 private:
-  Production const * m_production;
-  LRState m_state;
-  Type m_type;
+  static Word const OPERAND_MASK=(Word(1) << OPERAND_BITS)-1;
+
+  Word m_value;
 };
 /**************************************************/
 
 /********************----- Helper Functions -----********************/
 LRAction ACCEPT();
-LRAction REDUCE(Production const * const i_production);
+LRAction ERROR();
+LRAction REDUCE(size_t const i_productionIndex);
 LRAction SHIFT(LRState const i_state);
 /**************************************************/
 
@@ -51,4 +82,62 @@ LRAction SHIFT(LRState const i_state);
 typedef std::set<LRAction> LRActionSet;
 /**************************************************/
 
+/********************----- Inline Functions -----********************/
+//Actions are unpacked on every parser step
+inline bool LRAction::isAccept() const
+{
+  return (this->type() == LRAction::Type::ACCEPT);
+}
+
+inline bool LRAction::isError() const
+{
+  return (this->type() == LRAction::Type::ERROR);
+}
+
+inline bool LRAction::isReduce() const
+{
+  return (this->type() == LRAction::Type::REDUCE);
+}
+
+inline bool LRAction::isShift() const
+{
+  return (this->type() == LRAction::Type::SHIFT);
+}
+
+inline uint32_t LRAction::productionIndex() const
+{
+  return uint32_t(m_value & OPERAND_MASK);
+}
+
+inline LRState LRAction::state() const
+{
+  return LRState(m_value & OPERAND_MASK);
+}
+
+inline LRAction::Type LRAction::type() const
+{
+  return static_cast<LRAction::Type>(m_value >> OPERAND_BITS);
+}
+
+inline LRAction::Word LRAction::value() const
+{
+  return m_value;
+}
+
+inline bool LRAction::operator <(LRAction const &i_otherAction) const
+{
+  return (m_value < i_otherAction.m_value);
+}
+
+inline bool LRAction::operator==(LRAction const &i_otherAction) const
+{
+  return (m_value == i_otherAction.m_value);
+}
+
+inline bool LRAction::operator!=(LRAction const &i_otherAction) const
+{
+  return (m_value != i_otherAction.m_value);
+}
+/**************************************************/
+
 #endif /* _LRACTION_HPP_ */
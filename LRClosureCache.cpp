@@ -0,0 +1,60 @@
+#include "LRClosureCache.hpp"
+
+#include <algorithm>
+
+/********************----- CLASS: LRClosureCache -----********************/
+LRClosureCache::LRClosureCache(size_t const i_capacity)
+:m_capacity(std::max<size_t>(1, i_capacity))
+{
+}
+
+size_t LRClosureCache::capacity() const
+{
+  return m_capacity;
+}
+
+void LRClosureCache::clear()
+{
+  m_index.clear();
+  m_entries.clear();
+}
+
+LRClosureCache::Entry const *LRClosureCache::find(LRItemSet const &i_kernelCores)
+{
+  EntryMap::iterator const eit=m_index.find(i_kernelCores);
+  if(eit == m_index.end())
+  {
+    return nullptr;
+  }
+
+  /***** Move to the front *****/
+  m_entries.splice(m_entries.begin(), m_entries, eit->second);
+  return &eit->second->second;
+}
+
+LRClosureCache::Entry const &LRClosureCache::insert(LRItemSet &&i_kernelCores, Entry &&i_entry)
+{
+  /***** Evict the least recently used entry *****/
+  if(m_entries.size() >= m_capacity)
+  {
+    m_index.erase(m_index.find(*m_entries.back().first));
+    m_entries.pop_back();
+  }
+
+  m_entries.emplace_front(nullptr, std::move(i_entry));
+  std::pair<EntryMap::iterator, bool> const indexPair=m_index.insert(EntryMap::value_type(std::move(i_kernelCores), m_entries.begin()));
+  if(!indexPair.second)
+  {
+    m_entries.erase(indexPair.first->second);
+    indexPair.first->second = m_entries.begin();
+  }
+  m_entries.front().first = &indexPair.first->first;
+
+  return m_entries.front().second;
+}
+
+size_t LRClosureCache::size() const
+{
+  return m_entries.size();
+}
+/**************************************************/
@@ -0,0 +1,49 @@
+#ifndef _LRCLOSURECACHE_HPP_
+#define _LRCLOSURECACHE_HPP_
+
+#include "LRItem.hpp"
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/********************----- CLASS: LRClosureCache -----********************/
+//Bounded LRU of closure shapes keyed by kernel cores. Which cores a closure
+//predicts, the lookaheads they get from FIRST and the items that pass their
+//own lookaheads on do not depend on the kernel's lookaheads, so every state
+//with the same kernel cores shares one entry.
+class LRClosureCache
+{
+public:
+  struct Entry
+  {
+    LRItemSet items;                 //Sorted closure cores with their FIRST lookaheads
+    std::vector<size_t> kernelIndices; //Position of each kernel core in items
+    std::vector<size_t> edgeOffsets;   //items[i] passes its lookaheads on to
+    std::vector<size_t> edgeTargets;   //edgeTargets[edgeOffsets[i]..edgeOffsets[i+1])
+  };
+
+  explicit LRClosureCache(size_t const i_capacity);
+  virtual ~LRClosureCache(){}
+
+  void clear();
+  Entry const *find(LRItemSet const &i_kernelCores);
+  Entry const &insert(LRItemSet &&i_kernelCores, Entry &&i_entry);
+
+  size_t capacity() const;
+  size_t size() const;
+private:
+  LRClosureCache(LRClosureCache const &)=delete;
+  LRClosureCache &operator =(LRClosureCache const &)=delete;
+
+  //Most recently used first; each entry points back at its key in m_index
+  typedef std::list<std::pair<LRItemSet const *, Entry>> EntryList;
+  typedef std::unordered_map<LRItemSet, EntryList::iterator> EntryMap;
+
+  size_t m_capacity;
+  EntryList m_entries;
+  EntryMap m_index;
+};
+/**************************************************/
+
+#endif /* _LRCLOSURECACHE_HPP_ */
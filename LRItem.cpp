@@ -1,155 +1,247 @@
 #include "LRItem.hpp"
-#include "Production.hpp"
+#include "CompiledGrammar.hpp"
 
+#include <algorithm>
 #include <iostream>
-
-#include <stddef.h>
-
-#include <memory>
+#include <numeric>
+#include <stdexcept>
 
 /********************----- CLASS: LRItem -----********************/
-LRItem::LRItem(Production const * const i_productionPointer, size_t const i_rightPosition, SymbolList const &i_lookahead)
-:m_productionPointer(i_productionPointer), m_rightPosition(i_rightPosition), m_lookahead(i_lookahead)
+void LRItem::checkLimits(CompiledGrammar const &i_grammar)
+{
+  if(i_grammar.productionCount() > (uint64_t(1) << PRODUCTION_BITS))
+  {
+    throw std::length_error("Too many productions for LRItem");
+  }
+  for(size_t i=0; i<i_grammar.productionCount(); ++i)
+  {
+    if(i_grammar.productionLength(i) >= (uint64_t(1) << POSITION_BITS))
+    {
+      throw std::length_error("Production too long for LRItem");
+    }
+  }
+}
+
+std::string LRItem::toString(CompiledGrammar const &i_grammar) const
 {
+  std::string outputString;
+  SymbolId const * const right=i_grammar.productionRight(this->production());
+  size_t const length=i_grammar.productionLength(this->production());
+
+  outputString += "[";
+  outputString += i_grammar.symbol(i_grammar.productionLeft(this->production())).toString();
+  outputString += " ::=";
+  for(size_t x=0; x<=length; ++x)
+  {
+    if(x == this->rightPosition())
+    {
+      outputString += " .";
+    }
+    if(x < length)
+    {
+      outputString += " " + i_grammar.symbol(right[x]).toString();
+    }
+  }
+  outputString += "]";
+
+  return outputString;
 }
+/**************************************************/
 
-LRItem::LRItem(Production const * const i_productionPointer, size_t const i_rightPosition)
-:m_productionPointer(i_productionPointer), m_rightPosition(i_rightPosition)
+/********************----- CLASS: LRItemSet -----********************/
+LRItemSet::LRItemSet(size_t const i_lookaheadWords)
+:m_lookaheadWords(i_lookaheadWords)
 {
 }
 
-CompareResult LRItem::compare(LRItem const &i_otherItem) const
+size_t LRItemSet::add(LRItem const &i_item)
 {
-  //This operator is used for insertion into a set
-  //Therefore I've tried to order the comparisons such that
-  //they sort in an order that makes sense for parsing
-  //to minimize the number of comparisons made
+  //Appends an item without lookaheads; call sort() once all items are added
+  m_items.push_back(i_item);
+  m_lookaheads.resize(m_lookaheads.size()+m_lookaheadWords, 0);
 
-  /***** 0: If same item *****/
-  if(this == &i_otherItem)
-  {
-    return CompareResult::EQUAL;
-  }
+  return m_items.size()-1;
+}
 
-  /***** 1: Check position *****/
-  if(m_rightPosition < i_otherItem.m_rightPosition)
-  {
-    return CompareResult::LESS;
-  }
-  else if(m_rightPosition > i_otherItem.m_rightPosition)
+bool LRItemSet::addLookahead(size_t const i_index, SymbolId const i_symbolId)
+{
+  uint64_t &word=m_lookaheads[i_index*m_lookaheadWords+i_symbolId/64];
+  uint64_t const bit=uint64_t(1) << (i_symbolId%64);
+  if(word & bit)
   {
-    return CompareResult::GREATER;
+    return false;
   }
 
-  /***** 2: Check production *****/
-  if(m_productionPointer < i_otherItem.m_productionPointer)
+  word |= bit;
+  return true;
+}
+
+bool LRItemSet::addLookaheads(size_t const i_index, uint64_t const * const i_lookaheads, SymbolId const i_excludedId)
+{
+  uint64_t *words=m_lookaheads.data()+i_index*m_lookaheadWords;
+  uint64_t changed=0;
+  for(size_t w=0; w<m_lookaheadWords; ++w)
   {
-    return CompareResult::LESS;
+    uint64_t addedBits=i_lookaheads[w];
+    if(w == i_excludedId/64)
+    {
+      addedBits &= ~(uint64_t(1) << (i_excludedId%64));
+    }
+    changed |= addedBits & ~words[w];
+    words[w] |= addedBits;
   }
-  else if(m_productionPointer > i_otherItem.m_productionPointer)
+
+  return (changed != 0);
+}
+
+void LRItemSet::clear()
+{
+  m_items.clear();
+  m_lookaheads.clear();
+}
+
+bool LRItemSet::empty() const
+{
+  return m_items.empty();
+}
+
+size_t LRItemSet::find(LRItem const &i_item) const
+{
+  std::vector<LRItem>::const_iterator iit=std::lower_bound(m_items.begin(), m_items.end(), i_item);
+  if(iit == m_items.end() || *iit != i_item)
   {
-    return CompareResult::GREATER;
+    return m_items.size();
   }
 
-  /***** 3: Check lookahead *****/
-  if(m_lookahead < i_otherItem.m_lookahead)
+  return iit-m_items.begin();
+}
+
+size_t LRItemSet::hash() const
+{
+  //Empty lookahead words are skipped, so widening a set keeps its hash
+  uint64_t hashValue=m_items.size();
+  for(size_t i=0; i<m_items.size(); ++i)
   {
-    return CompareResult::LESS;
+    hashValue = (hashValue ^ m_items[i].value()) * 0x100000001B3ull;
+    hashValue ^= hashValue >> 29;
+    for(size_t w=0; w<m_lookaheadWords; ++w)
+    {
+      uint64_t const word=m_lookaheads[i*m_lookaheadWords+w];
+      if(word != 0)
+      {
+        hashValue = (hashValue ^ w) * 0x100000001B3ull;
+        hashValue = (hashValue ^ word) * 0x100000001B3ull;
+        hashValue ^= hashValue >> 29;
+      }
+    }
   }
-  else if(m_lookahead > i_otherItem.m_lookahead)
+
+  return size_t(hashValue);
+}
+
+size_t LRItemSet::lookaheadCount() const
+{
+  size_t lookaheadCount=0;
+  for(uint64_t const word : m_lookaheads)
   {
-    return CompareResult::GREATER;
+    lookaheadCount += __builtin_popcountll(word);
   }
 
-  /***** They are equal *****/
-  return CompareResult::EQUAL;
+  return lookaheadCount;
 }
 
-SymbolList const &LRItem::lookahead() const
+size_t LRItemSet::lookaheadWords() const
 {
-  return m_lookahead;
+  return m_lookaheadWords;
 }
 
-Production const &LRItem::production() const
+void LRItemSet::resizeLookaheads(size_t const i_lookaheadWords)
 {
-  if(m_productionPointer == nullptr)
+  if(i_lookaheadWords == m_lookaheadWords)
+  {
+    return;
+  }
+
+  std::vector<uint64_t> lookaheads(m_items.size()*i_lookaheadWords, 0);
+  for(size_t i=0; i<m_items.size(); ++i)
   {
-    throw std::bad_weak_ptr();
+    std::copy(this->lookaheads(i), this->lookaheads(i)+std::min(m_lookaheadWords, i_lookaheadWords), lookaheads.begin()+i*i_lookaheadWords);
   }
 
-  return (*m_productionPointer);
+  m_lookaheads = std::move(lookaheads);
+  m_lookaheadWords = i_lookaheadWords;
 }
 
-size_t LRItem::rightPosition() const
+size_t LRItemSet::sizeBytes() const
 {
-  return m_rightPosition;
+  return sizeof(LRItemSet) + m_items.capacity()*sizeof(LRItem) + m_lookaheads.capacity()*sizeof(uint64_t);
 }
 
-std::string LRItem::toString() const
+void LRItemSet::sort()
 {
-  std::string outputString;
+  /***** Order cores, merging the lookaheads of repeated ones *****/
+  std::vector<size_t> order(m_items.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [this](size_t const i_a, size_t const i_b){return m_items[i_a] < m_items[i_b];});
 
-  outputString += "[";
-  outputString += m_productionPointer->left().toString();
-  outputString += " ::= ";
-  outputString += m_productionPointer->right().sublist(0, m_rightPosition).toString();
-  outputString += " . ";
-  if(m_rightPosition < m_productionPointer->right().count())
+  LRItemSet sortedSet(m_lookaheadWords);
+  for(size_t const i : order)
   {
-    outputString += m_productionPointer->right().sublist(m_rightPosition).toString();
+    if(sortedSet.empty() || sortedSet.m_items.back() != m_items[i])
+    {
+      sortedSet.add(m_items[i]);
+    }
+    sortedSet.addLookaheads(sortedSet.size()-1, this->lookaheads(i));
   }
-  outputString += " , ";
-  outputString += m_lookahead.toString();
-  outputString += "]";
 
-  return outputString;
+  (*this) = std::move(sortedSet);
 }
 
-bool LRItem::operator <(LRItem const &i_otherItem) const
+std::string LRItemSet::toString(CompiledGrammar const &i_grammar) const
 {
-  return (this->compare(i_otherItem) == CompareResult::LESS);
+  std::string outputString;
+  for(size_t i=0; i<m_items.size(); ++i)
+  {
+    outputString += m_items[i].toString(i_grammar) + " {";
+    for(SymbolId s=0; s<m_lookaheadWords*64; ++s)
+    {
+      if(this->lookaheads(i)[s/64] & (uint64_t(1) << (s%64)))
+      {
+        outputString += " " + i_grammar.symbol(s).toString();
+      }
+    }
+    outputString += " }\n";
+  }
+
+  return outputString;
 }
 
-bool LRItem::operator ==(LRItem const &i_otherItem) const
+bool LRItemSet::operator ==(LRItemSet const &i_otherSet) const
 {
-  return (this->compare(i_otherItem) == CompareResult::EQUAL);
+  return (m_items == i_otherSet.m_items && m_lookaheads == i_otherSet.m_lookaheads);
 }
 
-bool LRItem::operator >(LRItem const &i_otherItem) const
+bool LRItemSet::operator !=(LRItemSet const &i_otherSet) const
 {
-  return (this->compare(i_otherItem) == CompareResult::GREATER);
+  return !((*this) == i_otherSet);
 }
 /**************************************************/
 
 /********************----- Helper Functions -----********************/
-void printItemSet(std::string const &i_name, LRItemSet const &i_itemSet)
+void printItemSet(std::string const &i_name, LRItemSet const &i_itemSet, CompiledGrammar const &i_grammar)
 {
   std::cout << "===== " << i_name << " =====" << std::endl;
-  for(LRItemSet::const_iterator lit=i_itemSet.begin(); lit!=i_itemSet.end();++lit)
-  {
-    {
-      std::cout << "\t" << lit->toString() << " ";
-    }
-
-    std::cout << std::endl;
-  }
+  std::cout << i_itemSet.toString(i_grammar);
   std::cout << "==================================================" << std::endl;
 }
 
-void printItemSetVector(std::string const &i_name, std::vector<LRItemSet> const &i_itemSetVector)
+void printItemSetVector(std::string const &i_name, LRItemSetVector const &i_itemSetVector, CompiledGrammar const &i_grammar)
 {
   std::cout << "===== " << i_name << " =====" << std::endl;
   for(size_t i=0; i<i_itemSetVector.size(); ++i)
   {
-    for(LRItemSet::const_iterator lit=i_itemSetVector[i].begin(); lit!=i_itemSetVector[i].end(); ++lit)
-    {
-      for(size_t x=0; x<i; ++x)
-      {
-        std::cout << "\t";
-      }
-
-      std::cout << lit->toString() << " " << std::endl;
-    }
+    std::cout << "State " << i << ":" << std::endl;
+    std::cout << i_itemSetVector[i].toString(i_grammar);
   }
 
   std::cout << "==================================================" << std::endl;
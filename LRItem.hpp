@@ -1,48 +1,185 @@
 #ifndef _LRITEM_HPP_
 #define _LRITEM_HPP_
 
-#include "SymbolList.hpp"
+#include "Symbol.hpp"
 #include "global.hpp"
 
+#include <cstdint>
 #include <stddef.h>
-#include <set>
+#include <vector>
 
-class Production;
+class CompiledGrammar;
 
 /********************----- CLASS: LRItem -----********************/
+//The core of an item packed into one word: dot position above production
+//index, so comparing words orders cores the same way the fields would.
+//Lookaheads are kept per core by LRItemSet.
 class LRItem
 {
 public:
-  LRItem(Production const * const i_productionPtr, size_t const i_rightPosition, SymbolList const &i_lookahead);
-  LRItem(Production const * const i_productionPtr, size_t const i_rightPosition);
+  static unsigned const PRODUCTION_BITS=32;
+  static unsigned const POSITION_BITS=32;
+
+  LRItem(size_t const i_productionIndex, size_t const i_rightPosition);
 
   CompareResult compare(LRItem const &i_otherItem) const;
+  static void checkLimits(CompiledGrammar const &i_grammar);
 
-  SymbolList const &lookahead() const;
-  Production const &production() const;
+  LRItem advance() const;
+  size_t production() const;
   size_t rightPosition() const;
+  uint64_t value() const;
 
-  std::string toString() const;
+  std::string toString(CompiledGrammar const &i_grammar) const;
 
   bool operator <(LRItem const &i_otherItem) const;
   bool operator ==(LRItem const &i_otherItem) const;
+  bool operator !=(LRItem const &i_otherItem) const;
   bool operator >(LRItem const &i_otherItem) const;
 private:
-  Production const *m_productionPointer;
-  size_t m_rightPosition;
-  SymbolList m_lookahead;
-  size_t m_iteration;
+  static unsigned const POSITION_SHIFT=PRODUCTION_BITS;
+
+  uint64_t m_value;
+};
+/**************************************************/
+
+/********************----- CLASS: LRItemSet -----********************/
+//Items grouped by core: each core appears once, in sorted order, with its
+//lookaheads as a bitset over symbol IDs. All bitsets of a set have the
+//same number of words, stored back to back.
+class LRItemSet
+{
+public:
+  explicit LRItemSet(size_t const i_lookaheadWords=0);
+
+  size_t add(LRItem const &i_item);
+  bool addLookahead(size_t const i_index, SymbolId const i_symbolId);
+  bool addLookaheads(size_t const i_index, uint64_t const * const i_lookaheads, SymbolId const i_excludedId=SYMBOLID_INVALID);
+  void clear();
+  void resizeLookaheads(size_t const i_lookaheadWords);
+  void sort();
+
+  bool empty() const;
+  size_t find(LRItem const &i_item) const;
+  size_t hash() const;
+  LRItem const &item(size_t const i_index) const;
+  size_t lookaheadCount() const;
+  uint64_t const *lookaheads(size_t const i_index) const;
+  size_t lookaheadWords() const;
+  size_t size() const;
+  size_t sizeBytes() const;
+
+  std::string toString(CompiledGrammar const &i_grammar) const;
+
+  bool operator ==(LRItemSet const &i_otherSet) const;
+  bool operator !=(LRItemSet const &i_otherSet) const;
+private:
+  std::vector<LRItem> m_items;
+  std::vector<uint64_t> m_lookaheads;
+  size_t m_lookaheadWords;
 };
 /**************************************************/
 
 /********************----- Types -----********************/
-typedef std::set<LRItem> LRItemSet;
 typedef std::vector<LRItemSet> LRItemSetVector;
 /**************************************************/
 
+/********************----- Hash Function -----********************/
+namespace std
+{
+  template <>
+  struct hash<LRItemSet>
+  {
+    size_t operator ()(LRItemSet const &i_itemSet) const
+    {
+      return i_itemSet.hash();
+    }
+  };
+}
+/**************************************************/
+
 /********************----- Helper Functions -----********************/
-void printItemSet(std::string const &i_name, LRItemSet const &i_itemSet);
-void printItemSetVector(std::string const &i_name, std::vector<LRItemSet> const &i_itemSetVector);
+void printItemSet(std::string const &i_name, LRItemSet const &i_itemSet, CompiledGrammar const &i_grammar);
+void printItemSetVector(std::string const &i_name, LRItemSetVector const &i_itemSetVector, CompiledGrammar const &i_grammar);
+/**************************************************/
+
+/********************----- Inline Functions -----********************/
+//Items are compared and unpacked in the innermost loops of table construction
+inline LRItem::LRItem(size_t const i_productionIndex, size_t const i_rightPosition)
+:m_value((uint64_t(i_rightPosition) << POSITION_SHIFT) | uint64_t(i_productionIndex))
+{
+}
+
+inline LRItem LRItem::advance() const
+{
+  LRItem nextItem(*this);
+  nextItem.m_value += uint64_t(1) << POSITION_SHIFT;
+  return nextItem;
+}
+
+inline CompareResult LRItem::compare(LRItem const &i_otherItem) const
+{
+  if(m_value < i_otherItem.m_value)
+  {
+    return CompareResult::LESS;
+  }
+  else if(m_value > i_otherItem.m_value)
+  {
+    return CompareResult::GREATER;
+  }
+
+  return CompareResult::EQUAL;
+}
+
+inline size_t LRItem::production() const
+{
+  return size_t(m_value & ((uint64_t(1) << PRODUCTION_BITS)-1));
+}
+
+inline size_t LRItem::rightPosition() const
+{
+  return size_t(m_value >> POSITION_SHIFT);
+}
+
+inline uint64_t LRItem::value() const
+{
+  return m_value;
+}
+
+inline bool LRItem::operator <(LRItem const &i_otherItem) const
+{
+  return (m_value < i_otherItem.m_value);
+}
+
+inline bool LRItem::operator ==(LRItem const &i_otherItem) const
+{
+  return (m_value == i_otherItem.m_value);
+}
+
+inline bool LRItem::operator !=(LRItem const &i_otherItem) const
+{
+  return (m_value != i_otherItem.m_value);
+}
+
+inline bool LRItem::operator >(LRItem const &i_otherItem) const
+{
+  return (m_value > i_otherItem.m_value);
+}
+
+inline LRItem const &LRItemSet::item(size_t const i_index) const
+{
+  return m_items[i_index];
+}
+
+inline uint64_t const *LRItemSet::lookaheads(size_t const i_index) const
+{
+  return m_lookaheads.data()+i_index*m_lookaheadWords;
+}
+
+inline size_t LRItemSet::size() const
+{
+  return m_items.size();
+}
 /**************************************************/
 
 #endif /* _LRITEM_HPP_ */
@@ -0,0 +1,62 @@
+#include "LRParseError.hpp"
+
+/********************----- CLASS: LRParseError -----********************/
+LRParseError::LRParseError(size_t const i_position, LRState const i_state, Symbol const &i_token, Repair const i_repair, Symbol const &i_repairToken, size_t const i_skipCount)
+:m_position(i_position), m_state(i_state), m_token(i_token), m_repair(i_repair), m_repairToken(i_repairToken), m_skipCount(i_skipCount)
+{
+}
+
+size_t LRParseError::position() const
+{
+  return m_position;
+}
+
+LRParseError::Repair LRParseError::repair() const
+{
+  return m_repair;
+}
+
+Symbol const &LRParseError::repairToken() const
+{
+  return m_repairToken;
+}
+
+size_t LRParseError::skipCount() const
+{
+  return m_skipCount;
+}
+
+LRState LRParseError::state() const
+{
+  return m_state;
+}
+
+Symbol const &LRParseError::token() const
+{
+  return m_token;
+}
+
+std::string LRParseError::toString() const
+{
+  std::string outputString;
+
+  outputString += "Unexpected " + m_token.toString() + " at token " + std::to_string(m_position) + " in state " + std::to_string(m_state);
+
+  switch(m_repair)
+  {
+    case LRParseError::Repair::DELETE:
+      outputString += " (deleted)";
+      break;
+    case LRParseError::Repair::INSERT:
+      outputString += " (inserted " + m_repairToken.toString() + ")";
+      break;
+    case LRParseError::Repair::SYNCHRONIZE:
+      outputString += " (skipped " + std::to_string(m_skipCount) + " tokens to " + m_repairToken.toString() + ")";
+      break;
+    default:
+      break;
+  }
+
+  return outputString;
+}
+/**************************************************/
@@ -0,0 +1,45 @@
+#ifndef _LRPARSEERROR_HPP_
+#define _LRPARSEERROR_HPP_
+
+#include "LRState.hpp"
+#include "Symbol.hpp"
+
+#include <vector>
+
+/********************----- CLASS: LRParseError -----********************/
+class LRParseError
+{
+public:
+  enum class Repair
+  {
+    NONE,
+    DELETE,
+    INSERT,
+    SYNCHRONIZE,
+  };
+
+  LRParseError(size_t const i_position, LRState const i_state, Symbol const &i_token, Repair const i_repair=Repair::NONE, Symbol const &i_repairToken=Symbol(Symbol::Type::T_NONE), size_t const i_skipCount=0);
+
+  size_t position() const;
+  Repair repair() const;
+  Symbol const &repairToken() const;
+  size_t skipCount() const;
+  LRState state() const;
+  Symbol const &token() const;
+
+  std::string toString() const;
+private:
+  size_t m_position;
+  LRState m_state;
+  Symbol m_token;
+  Repair m_repair;
+  Symbol m_repairToken;
+  size_t m_skipCount;
+};
+/**************************************************/
+
+/********************----- Types -----********************/
+typedef std::vector<LRParseError> LRParseErrorVector;
+/**************************************************/
+
+#endif /* _LRPARSEERROR_HPP_ */
@@ -5,61 +5,464 @@
 #include "Grammar.hpp"
 #include "Production.hpp"
 
-#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <set>
+#include <thread>
 
 /********************----- CLASS: LRParser -----********************/
-LRParser::LRParser(LRTable::Type const i_type, size_t const i_k, Grammar const &i_grammar)
-:m_table(i_type, i_grammar)
+size_t const LRParser::REPAIR_MAX_INSERTIONS;
+
+LRParser::LRParser(LRTable::Type const i_type, size_t const i_k, Grammar const &i_grammar, LRStats * const io_stats)
+:m_table(new LRTable(i_type, i_grammar, io_stats)), m_type(i_type), m_unitRules(UnitRules::KEEP), m_recovery(Recovery::NONE), m_insertCost(1), m_deleteCost(1), m_maxErrors(std::numeric_limits<size_t>::max())
 {
-  m_stackState.push(LRState(0));
 }
 
-bool LRParser::parse(Lex &i_lex)
+LRParser::LRParser(LRTable::Type const i_type, size_t const i_k, CompiledGrammar const &i_grammar, LRStats * const io_stats)
+:m_table(new LRTable(i_type, i_grammar, io_stats)), m_type(i_type), m_unitRules(UnitRules::KEEP), m_recovery(Recovery::NONE), m_insertCost(1), m_deleteCost(1), m_maxErrors(std::numeric_limits<size_t>::max())
 {
-  bool accepted=false;
-  Symbol token = i_lex.pop();
-  while(!m_stackState.empty())
-  {
-    LRState state=m_stackState.top();
-    LRAction const &action=m_table.action(state, token);
+}
+
+void LRParser::addSplitToken(Symbol const &i_token)
+{
+  m_splitTokens.insert(i_token);
+}
 
-#ifndef NDEBUG
-    std::cout << "(" + std::to_string(state) + " + " + token.toString() + ") --> " + action.toString() << std::endl;
-#endif
+void LRParser::addSyncToken(Symbol const &i_token)
+{
+  m_syncTokens.insert(i_token);
+}
 
+bool LRParser::advance(LRTable const &i_table, LRStateStack &io_stack, Symbol const &i_token)
+{
+  //Runs the automaton on a copy of the state stack until i_token is consumed
+  while(!io_stack.empty())
+  {
+    LRAction const action=i_table.action(io_stack.back(), i_token);
     if(action.isShift())
     {
-      m_stackSymbol.push(token);
-      m_stackState.push(action.state());
-      token=i_lex.pop();
+      io_stack.push_back(action.state());
+      return true;
+    }
+    else if(action.isAccept())
+    {
+      return true;
     }
     else if(action.isReduce())
     {
-      Production const &p = action.production();
-      Symbol const &leftSymbol = p.left()[0];
-      SymbolList const &right = p.right();
-      size_t const popCount = right.count();
-      for(size_t x=0; x<popCount; ++x)
+      size_t const popCount = i_table.productionLength(action.productionIndex());
+      if(popCount >= io_stack.size())
       {
-        m_stackSymbol.pop();
-        m_stackState.pop();
+        return false;
       }
-      m_stackSymbol.push(leftSymbol);
-      m_stackState.push(m_table.path(state, leftSymbol));
+      io_stack.resize(io_stack.size()-popCount);
+      io_stack.push_back(i_table.path(io_stack.back(), i_table.productionLeft(action.productionIndex())));
     }
-    else if(action.isAccept())
+    else
+    {
+      return false;
+    }
+  }
+
+  return false;
+}
+
+LRParseErrorVector const &LRParser::errors() const
+{
+  return m_session.errors();
+}
+
+bool LRParser::parse(Lex &i_lex)
+{
+  return this->parse(i_lex, m_session);
+}
+
+bool LRParser::parse(Lex &i_lex, ParseSession &io_session) const
+{
+  NoEvents noEvents;
+  return this->parse(i_lex, io_session, noEvents);
+}
+
+bool LRParser::parseChunk(ParallelChunk &io_chunk, Symbol const * const i_tokens, size_t const i_tokenCount, std::shared_ptr<LRTable const> const &i_table, ParseSession const * const i_entry, bool const i_record) const
+{
+  //Chunks always count; replayChunk() only keeps the counts if the caller does
+  ParseSession &session=io_chunk.session;
+  session.m_speculative = true;
+  session.m_counting = true;
+  session.reset();
+  session.m_table = i_table;
+  if(i_entry != nullptr)
+  {
+    session.assignStack(*i_entry, i_entry->m_stackState.size());
+    session.m_maxDepth = session.m_stackState.size();
+  }
+  session.m_position = io_chunk.begin;
+  io_chunk.events.clear();
+
+  /***** Run up to the shift of the next chunk's first token, so the reductions it triggers land here *****/
+  bool const last=(io_chunk.end >= i_tokenCount);
+  size_t const runEnd=(last ? i_tokenCount : io_chunk.end+1);
+  if(i_record)
+  {
+    ParallelRecorder recorder{io_chunk.events};
+    this->push(session, i_tokens+io_chunk.begin, runEnd-io_chunk.begin, recorder);
+  }
+  else
+  {
+    this->push(session, i_tokens+io_chunk.begin, runEnd-io_chunk.begin);
+  }
+
+  if(last)
+  {
+    io_chunk.ok = (session.m_status != ParseSession::Status::ERROR);
+    return io_chunk.ok;
+  }
+
+  /***** Give that shift back; the next chunk starts with it *****/
+  io_chunk.ok = (session.m_status == ParseSession::Status::NEED_MORE);
+  if(io_chunk.ok)
+  {
+    session.m_stackState.pop_back();
+    session.m_stackSymbol.pop_back();
+    session.m_stackBegin.pop_back();
+    --session.m_shiftCount;
+    session.m_position = io_chunk.end;
+    if(i_record)
+    {
+      io_chunk.events.pop_back();
+    }
+  }
+
+  return io_chunk.ok;
+}
+
+bool LRParser::parseParallel(Lex &i_lex, ParseSession &io_session, size_t const i_threadCount) const
+{
+  /***** Lex ahead, split points can only be found in the whole input *****/
+  SymbolStack tokens;
+  do
+  {
+    tokens.push_back(i_lex.pop());
+  }
+  while(!tokens.back().isEND());
+
+  return this->parseParallel(tokens.data(), tokens.size(), io_session, i_threadCount);
+}
+
+bool LRParser::parseParallel(Symbol const * const i_tokens, size_t const i_tokenCount, ParseSession &io_session, size_t const i_threadCount) const
+{
+  NoEvents noEvents;
+  return this->parseParallel(i_tokens, i_tokenCount, io_session, i_threadCount, noEvents);
+}
+
+ParseSession::Status LRParser::push(ParseSession &io_session, Symbol &&i_token) const
+{
+  NoEvents noEvents;
+  return this->push(io_session, std::move(i_token), noEvents);
+}
+
+ParseSession::Status LRParser::push(ParseSession &io_session, Symbol const &i_token) const
+{
+  return this->push(io_session, Symbol(i_token));
+}
+
+ParseSession::Status LRParser::push(ParseSession &io_session, Symbol const * const i_tokens, size_t const i_tokenCount) const
+{
+  NoEvents noEvents;
+  return this->push(io_session, i_tokens, i_tokenCount, noEvents);
+}
+
+bool LRParser::recover(ParseSession &io_session, Symbol const &i_token) const
+{
+  //Returns true if i_token should be run through the automaton again
+
+  /***** Give up *****/
+  if(m_recovery == Recovery::NONE || io_session.m_speculative || io_session.m_errors.size()+1 >= m_maxErrors)
+  {
+    io_session.m_errors.push_back(LRParseError(io_session.m_position-1, io_session.m_stackState.back(), i_token));
+    io_session.m_status = ParseSession::Status::ERROR;
+    return false;
+  }
+
+  /***** Try to continue *****/
+  switch(m_recovery)
+  {
+    case Recovery::PANIC:
+      return this->recoverPanic(io_session, i_token);
+    case Recovery::REPAIR:
+      return this->recoverRepair(io_session, i_token);
+    default:
+      io_session.m_status = ParseSession::Status::ERROR;
+      return false;
+  }
+}
+
+bool LRParser::recoverPanic(ParseSession &io_session, Symbol const &i_token) const
+{
+  //Recorded now so it is reported even if the input ends while skipping;
+  //synchronize() replaces it with the completed record
+  io_session.m_errors.push_back(LRParseError(io_session.m_position-1, io_session.m_stackState.back(), i_token));
+  io_session.m_skipCount = 0;
+
+  /***** Already synchronized on this token once - drop it so we make progress *****/
+  bool const isSyncToken=(m_syncTokens.find(i_token) != m_syncTokens.end());
+  if(io_session.m_position == io_session.m_recoveryPosition || !(isSyncToken || i_token.isEND()))
+  {
+    if(i_token.isEND())
+    {
+      io_session.m_status = ParseSession::Status::ERROR;
+      return false;
+    }
+
+    io_session.m_skipping = true;
+    io_session.m_skipCount = 1;
+    return false;
+  }
+
+  return this->synchronize(io_session, i_token);
+}
+
+bool LRParser::recoverRepair(ParseSession &io_session, Symbol const &i_token) const
+{
+  //Picks the cheapest of deleting i_token and inserting a run of up to
+  //REPAIR_MAX_INSERTIONS tokens after which it can be consumed. The input
+  //after i_token is not known yet, so a deletion is judged when the next
+  //token arrives, and another error there makes a new repair
+  LRTable const &table=*io_session.m_table;
+  LRState const errorState=io_session.m_stackState.back();
+  size_t const errorPosition=io_session.m_position-1;
+
+  /***** Search insertions breadth first, only as deep as they beat deleting *****/
+  //END cannot be deleted, so insertion is the only option there
+  size_t maxInsertions=REPAIR_MAX_INSERTIONS;
+  if(!i_token.isEND() && m_insertCost > 0)
+  {
+    maxInsertions = std::min(maxInsertions, m_deleteCost/m_insertCost);
+  }
+
+  struct RepairTrial
+  {
+    LRStateStack stack;
+    SymbolStack insertions;
+  };
+  std::vector<RepairTrial> trials;
+  trials.push_back(RepairTrial{io_session.m_stackState, SymbolStack()});
+  std::set<LRStateStack> seenStacks;
+  for(size_t depth=0; depth<maxInsertions && !trials.empty(); ++depth)
+  {
+    std::vector<RepairTrial> nextTrials;
+    for(RepairTrial const &trial : trials)
+    {
+      SymbolSet const candidates=table.expected(trial.stack.back());
+      for(SymbolSet::const_iterator cit=candidates.begin(); cit!=candidates.end(); ++cit)
+      {
+        //Runs reaching a stack already seen are no better than the shorter one
+        LRStateStack candidateStack(trial.stack);
+        if(cit->isEND() || !LRParser::advance(table, candidateStack, *cit) || !seenStacks.insert(candidateStack).second)
+        {
+          continue;
+        }
+
+        RepairTrial nextTrial{std::move(candidateStack), trial.insertions};
+        nextTrial.insertions.push_back(*cit);
+        LRStateStack tokenStack(nextTrial.stack);
+        if(LRParser::advance(table, tokenStack, i_token))
+        {
+          //One error record per inserted token, all at the error position
+          for(Symbol const &inserted : nextTrial.insertions)
+          {
+            io_session.m_errors.push_back(LRParseError(errorPosition, errorState, i_token, LRParseError::Repair::INSERT, inserted));
+          }
+          io_session.m_insertions.swap(nextTrial.insertions);
+          return true;
+        }
+        nextTrials.push_back(std::move(nextTrial));
+      }
+    }
+    trials.swap(nextTrials);
+  }
+
+  /***** Otherwise delete the offending token *****/
+  if(i_token.isEND())
+  {
+    io_session.m_errors.push_back(LRParseError(errorPosition, errorState, i_token));
+    io_session.m_status = ParseSession::Status::ERROR;
+    return false;
+  }
+
+  io_session.m_errors.push_back(LRParseError(errorPosition, errorState, i_token, LRParseError::Repair::DELETE, i_token, 1));
+  return false;
+}
+
+void LRParser::setMaxErrors(size_t const i_maxErrors)
+{
+  m_maxErrors = i_maxErrors;
+}
+
+void LRParser::setRecovery(Recovery const i_recovery)
+{
+  m_recovery = i_recovery;
+}
+
+void LRParser::setRepairCosts(size_t const i_insertCost, size_t const i_deleteCost)
+{
+  m_insertCost = i_insertCost;
+  m_deleteCost = i_deleteCost;
+}
+
+void LRParser::setUnitRules(UnitRules const i_unitRules)
+{
+  m_unitRules = i_unitRules;
+}
+
+void LRParser::speculateChunk(ParallelChunk &io_chunk, Symbol const * const i_tokens, size_t const i_tokenCount, ParseSession const &i_entry, bool const i_record) const
+{
+  //A split token inside a nested item makes the entry stack wrong, which
+  //usually shows up as an error soon after; start again after the next split
+  while(!this->parseChunk(io_chunk, i_tokens, i_tokenCount, i_entry.m_table, &i_entry, i_record))
+  {
+    size_t begin=io_chunk.session.m_position;
+    while(begin < io_chunk.end && m_splitTokens.find(i_tokens[begin-1]) == m_splitTokens.end())
+    {
+      ++begin;
+    }
+    if(begin >= io_chunk.end)
+    {
+      return;
+    }
+    io_chunk.begin = begin;
+  }
+}
+
+bool LRParser::splitParallel(Symbol const * const i_tokens, size_t const i_tokenCount, size_t const i_threadCount, bool const i_record, ParallelChunkDeque &o_chunks, ParseSession &o_entry) const
+{
+  o_chunks.clear();
+  if(m_splitTokens.empty())
+  {
+    return false;
+  }
+
+  /***** Probe the start of the input for the stack to start chunks from *****/
+  //The stack just before the token after a split is shifted. Top-level
+  //items leave the least on the stack, so the shallowest one is kept
+  ParseSession probe;
+  probe.m_speculative = true;
+  probe.reset();
+  probe.m_table = o_entry.m_table;
+  bool found=false;
+  size_t splitCount=0;
+  size_t const probeEnd=i_tokenCount/i_threadCount;
+  for(size_t i=0; i<probeEnd && splitCount<PARALLEL_PROBE_SPLITS; ++i)
+  {
+    bool const afterSplit=(i > 0 && m_splitTokens.find(i_tokens[i-1]) != m_splitTokens.end());
+    if(this->push(probe, i_tokens[i]) != ParseSession::Status::NEED_MORE)
     {
-      accepted=true;
       break;
     }
-    else
+
+    if(afterSplit)
+    {
+      ++splitCount;
+      if(!found || probe.m_stackState.size() <= o_entry.m_stackState.size())
+      {
+        found = true;
+        o_entry.assignStack(probe, probe.m_stackState.size()-1);
+      }
+    }
+  }
+  if(!found)
+  {
+    return false;
+  }
+
+  /***** Cut after the first split token past each even share of the input *****/
+  std::vector<size_t> bounds(1, 0);
+  for(size_t t=1; t<i_threadCount; ++t)
+  {
+    size_t bound=std::max(t*i_tokenCount/i_threadCount, bounds.back()+1);
+    while(bound < i_tokenCount && m_splitTokens.find(i_tokens[bound-1]) == m_splitTokens.end())
+    {
+      ++bound;
+    }
+    if(bound >= i_tokenCount)
+    {
+      break;
+    }
+    bounds.push_back(bound);
+  }
+  if(bounds.size() < 2)
+  {
+    return false;
+  }
+
+  for(size_t c=0; c<bounds.size(); ++c)
+  {
+    o_chunks.emplace_back();
+    o_chunks.back().begin = bounds[c];
+    o_chunks.back().end = (c+1 < bounds.size()) ? bounds[c+1] : i_tokenCount;
+  }
+
+  /***** The first chunk runs here from the real initial stack, the rest on their own threads *****/
+  std::vector<std::thread> threads;
+  for(size_t c=1; c<o_chunks.size(); ++c)
+  {
+    threads.push_back(std::thread(&LRParser::speculateChunk, this, std::ref(o_chunks[c]), i_tokens, i_tokenCount, std::cref(o_entry), i_record));
+  }
+  this->parseChunk(o_chunks.front(), i_tokens, i_tokenCount, o_entry.m_table, nullptr, i_record);
+  for(std::thread &thread : threads)
+  {
+    thread.join();
+  }
+
+  return true;
+}
+
+bool LRParser::synchronize(ParseSession &io_session, Symbol const &i_token) const
+{
+  /***** Unwind to a state that can act on the synchronizing token *****/
+  while(!io_session.m_stackState.empty() && io_session.m_table->action(io_session.m_stackState.back(), i_token).isError())
+  {
+    io_session.m_stackState.pop_back();
+    if(!io_session.m_stackSymbol.empty())
     {
-      throw std::runtime_error("NOES!");
+      io_session.m_stackSymbol.pop_back();
     }
   }
+  io_session.m_stackBegin.resize(io_session.m_stackSymbol.size());
+  if(io_session.m_tree != nullptr)
+  {
+    io_session.m_tree->truncate(io_session.m_stackSymbol.size());
+  }
+
+  io_session.m_skipping = false;
+  io_session.m_recoveryPosition = io_session.m_position;
+  if(io_session.m_stackState.empty())
+  {
+    io_session.m_status = ParseSession::Status::ERROR;
+    return false;
+  }
+
+  /***** Complete the error recorded when skipping started *****/
+  LRParseError const pendingError(io_session.m_errors.back());
+  io_session.m_errors.pop_back();
+  io_session.m_errors.push_back(LRParseError(pendingError.position(), pendingError.state(), pendingError.token(), LRParseError::Repair::SYNCHRONIZE, i_token, io_session.m_skipCount));
 
-  return accepted;
+  return true;
 }
-/**************************************************/
 
+//The table parses started now would use; it stays valid after an update()
+std::shared_ptr<LRTable const> LRParser::table() const
+{
+  return std::atomic_load(&m_table);
+}
 
+void LRParser::update(Grammar const &i_grammar, LRStats * const io_stats)
+{
+  //The current table is never touched, so it is safe to parse with while
+  //this runs; updates themselves must not overlap
+  std::shared_ptr<LRTable> updatedTable(new LRTable(*std::atomic_load(&m_table)));
+  updatedTable->update(i_grammar, io_stats);
+  std::atomic_store(&m_table, std::shared_ptr<LRTable const>(std::move(updatedTable)));
+}
+/**************************************************/
@@ -1,21 +1,130 @@
 #ifndef _LRPARSER_HPP_
 #define _LRPARSER_HPP_
 
+#include "CompiledGrammar.hpp"
 #include "Grammar.hpp"
 #include "Lex.hpp"
+#include "LRParseError.hpp"
 #include "LRTable.hpp"
+#include "ParseSession.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 class Grammar;
 class Production;
 
 /********************----- CLASS: LRParser -----********************/
+//Once configured, a parser is read-only while parsing into a ParseSession,
+//so one parser (and its table) can be shared by any number of threads.
+//update() builds a new table and swaps it in; sessions already parsing
+//finish on the table they started with.
 class LRParser
 {
 public:
-  LRParser(LRTable::Type const i_type, size_t const i_k, Grammar const &i_grammar);
+  enum class Recovery
+  {
+    NONE,
+    PANIC,
+    REPAIR,
+  };
+
+  //States whose only action is a unit reduction A ::= B can be bypassed;
+  //REPORT still counts and traces every bypassed reduction
+  enum class UnitRules
+  {
+    KEEP,
+    BYPASS,
+    REPORT,
+  };
+
+  //Handlers given to parse() or push() are called as each step happens:
+  //  void shift(Symbol const &i_token, size_t const i_position);
+  //  void reduce(uint32_t const i_production, size_t const i_tokenBegin, size_t const i_tokenEnd);
+  //They are template parameters, so calls inline and empty ones cost nothing
+  struct NoEvents
+  {
+    void shift(Symbol const &, size_t const){}
+    void reduce(uint32_t const, size_t const, size_t const){}
+  };
+
+  LRParser(LRTable::Type const i_type, size_t const i_k, Grammar const &i_grammar, LRStats * const io_stats=nullptr);
+  //Built once from a frozen grammar; update() is not available then
+  LRParser(LRTable::Type const i_type, size_t const i_k, CompiledGrammar const &i_grammar, LRStats * const io_stats=nullptr);
   virtual ~LRParser(){}
 
   bool parse(Lex &i_lex);
+  bool parse(Lex &i_lex, ParseSession &io_session) const;
+  template<typename Handler> bool parse(Lex &i_lex, ParseSession &io_session, Handler &io_handler) const;
+  ParseSession::Status push(ParseSession &io_session, Symbol &&i_token) const;
+  template<typename Handler> ParseSession::Status push(ParseSession &io_session, Symbol &&i_token, Handler &io_handler) const;
+  ParseSession::Status push(ParseSession &io_session, Symbol const &i_token) const;
+  ParseSession::Status push(ParseSession &io_session, Symbol const * const i_tokens, size_t const i_tokenCount) const;
+  template<typename Handler> ParseSession::Status push(ParseSession &io_session, Symbol const * const i_tokens, size_t const i_tokenCount, Handler &io_handler) const;
+  void update(Grammar const &i_grammar, LRStats * const io_stats=nullptr);
+
+  //Splits the input after split tokens (see addSplitToken()) and parses the
+  //pieces on separate threads, each from the shallowest stack seen after a
+  //split near the start of the input. A piece that fails from there moves
+  //on to the next split. Pieces that did not start from the stack their
+  //predecessor left, and the gaps between pieces, are parsed in order, as is
+  //everything after a syntax error, so results match parse() exactly
+  bool parseParallel(Lex &i_lex, ParseSession &io_session, size_t const i_threadCount) const;
+  bool parseParallel(Symbol const * const i_tokens, size_t const i_tokenCount, ParseSession &io_session, size_t const i_threadCount) const;
+  template<typename Handler> bool parseParallel(Symbol const * const i_tokens, size_t const i_tokenCount, ParseSession &io_session, size_t const i_threadCount, Handler &io_handler) const;
+
+  void addSplitToken(Symbol const &i_token);
+  void addSyncToken(Symbol const &i_token);
+  LRParseErrorVector const &errors() const;
+  void setMaxErrors(size_t const i_maxErrors);
+  void setRecovery(Recovery const i_recovery);
+  void setRepairCosts(size_t const i_insertCost, size_t const i_deleteCost);
+  void setUnitRules(UnitRules const i_unitRules);
+  std::shared_ptr<LRTable const> table() const;
+
+protected:
+  //Steps a chunk took, replayed in order into the caller's session;
+  //production is ParseTree::TOKEN for a shift
+  struct ParallelEvent
+  {
+    uint32_t production;
+    size_t position;
+  };
+  struct ParallelChunk
+  {
+    size_t begin; //First token
+    size_t end;   //First token of the next chunk, run only up to its shift
+    bool ok;
+    ParseSession session;
+    std::vector<ParallelEvent> events;
+  };
+  typedef std::deque<ParallelChunk> ParallelChunkDeque;
+  struct ParallelRecorder
+  {
+    std::vector<ParallelEvent> &events;
+    void shift(Symbol const &, size_t const i_position){ events.push_back(ParallelEvent{ParseTree::TOKEN, i_position}); }
+    void reduce(uint32_t const i_production, size_t const, size_t const i_tokenEnd){ events.push_back(ParallelEvent{i_production, i_tokenEnd}); }
+  };
+
+  //Split points probed for the entry stack before the chunks start
+  static size_t const PARALLEL_PROBE_SPLITS=64;
+  //Longest run of tokens REPAIR recovery inserts before an unexpected token
+  static size_t const REPAIR_MAX_INSERTIONS=3;
+
+  static bool advance(LRTable const &i_table, LRStateStack &io_stack, Symbol const &i_token);
+  template<typename Handler> ParseSession::Status consume(ParseSession &io_session, Symbol &&i_token, Handler &io_handler) const;
+  bool parseChunk(ParallelChunk &io_chunk, Symbol const * const i_tokens, size_t const i_tokenCount, std::shared_ptr<LRTable const> const &i_table, ParseSession const * const i_entry, bool const i_record) const;
+  bool recover(ParseSession &io_session, Symbol const &i_token) const;
+  bool recoverPanic(ParseSession &io_session, Symbol const &i_token) const;
+  bool recoverRepair(ParseSession &io_session, Symbol const &i_token) const;
+  template<typename Handler> void replayChunk(ParallelChunk const &i_chunk, Symbol const * const i_tokens, bool const i_record, ParseSession &io_session, Handler &io_handler) const;
+  void speculateChunk(ParallelChunk &io_chunk, Symbol const * const i_tokens, size_t const i_tokenCount, ParseSession const &i_entry, bool const i_record) const;
+  bool splitParallel(Symbol const * const i_tokens, size_t const i_tokenCount, size_t const i_threadCount, bool const i_record, ParallelChunkDeque &o_chunks, ParseSession &o_entry) const;
+  bool synchronize(ParseSession &io_session, Symbol const &i_token) const;
 
 private:
   LRParser(LRParser const &)=delete;
@@ -23,11 +132,311 @@ private:
   LRParser &operator =(LRParser const &)=delete;
   LRParser &operator =(LRParser &&)=delete;
 
-  LRStateStack m_stackState;
-  SymbolStack m_stackSymbol;
-  LRTable m_table;
+  //Never changed in place; update() swaps in a new one atomically
+  std::shared_ptr<LRTable const> m_table;
   LRTable::Type m_type;
+  ParseSession m_session;
+  UnitRules m_unitRules;
+  SymbolSet m_splitTokens;
+
+  /***** Error recovery *****/
+  Recovery m_recovery;
+  SymbolSet m_syncTokens;
+  size_t m_insertCost;
+  size_t m_deleteCost;
+  size_t m_maxErrors;
 };
 /**************************************************/
 
+/********************----- Template Functions -----********************/
+template<typename Handler> bool LRParser::parse(Lex &i_lex, ParseSession &io_session, Handler &io_handler) const
+{
+  io_session.reset();
+
+  ParseSession::Status status=ParseSession::Status::NEED_MORE;
+  while(status == ParseSession::Status::NEED_MORE)
+  {
+    Symbol token=i_lex.pop();
+    bool const endOfInput=token.isEND();
+
+    status=this->push(io_session, std::move(token), io_handler);
+    if(endOfInput && status == ParseSession::Status::NEED_MORE)
+    {
+      break;
+    }
+  }
+
+  return (status == ParseSession::Status::ACCEPTED && io_session.m_errors.empty());
+}
+
+template<typename Handler> bool LRParser::parseParallel(Symbol const * const i_tokens, size_t const i_tokenCount, ParseSession &io_session, size_t const i_threadCount, Handler &io_handler) const
+{
+  io_session.reset();
+  io_session.m_table = std::atomic_load(&m_table);
+
+  //Chunks only log their steps when something is listening; a trace needs
+  //every step as it happens, so traced sessions are parsed in order
+  bool const record=(io_session.m_tree != nullptr || !std::is_same<Handler, NoEvents>::value);
+  ParallelChunkDeque chunks;
+  ParseSession entry;
+  entry.m_table = io_session.m_table;
+  size_t parsedEnd=0;
+  if(io_session.m_trace == nullptr && i_threadCount > 1 && this->splitParallel(i_tokens, i_tokenCount, i_threadCount, record, chunks, entry))
+  {
+    ParallelChunk gap;
+    for(ParallelChunk &chunk : chunks)
+    {
+      /***** A chunk that moved past a bad split leaves a gap to parse in order *****/
+      if(!chunk.ok)
+      {
+        chunk.begin = parsedEnd;
+      }
+      else if(chunk.begin > parsedEnd)
+      {
+        gap.begin = parsedEnd;
+        gap.end = chunk.begin;
+        if(!this->parseChunk(gap, i_tokens, i_tokenCount, io_session.m_table, &io_session, record))
+        {
+          break;
+        }
+        this->replayChunk(gap, i_tokens, record, io_session, io_handler);
+        parsedEnd = gap.end;
+      }
+
+      /***** Redo a chunk whose guessed starting stack was wrong *****/
+      bool const startMatches=(chunk.begin == 0 || io_session.m_stackState == entry.m_stackState);
+      if(!(chunk.ok && startMatches) && !this->parseChunk(chunk, i_tokens, i_tokenCount, io_session.m_table, &io_session, record))
+      {
+        break;
+      }
+
+      this->replayChunk(chunk, i_tokens, record, io_session, io_handler);
+      parsedEnd = chunk.end;
+    }
+  }
+
+  /***** Whatever is left, including anything after a syntax error, is parsed in order *****/
+  if(parsedEnd < i_tokenCount)
+  {
+    this->push(io_session, i_tokens+parsedEnd, i_tokenCount-parsedEnd, io_handler);
+  }
+
+  return (io_session.m_status == ParseSession::Status::ACCEPTED && io_session.m_errors.empty());
+}
+
+template<typename Handler> ParseSession::Status LRParser::push(ParseSession &io_session, Symbol &&i_token, Handler &io_handler) const
+{
+  /***** Finished sessions stay finished until reset *****/
+  if(io_session.m_status != ParseSession::Status::NEED_MORE)
+  {
+    return io_session.m_status;
+  }
+
+  /***** A session keeps the table it started on until reset *****/
+  if(io_session.m_table == nullptr)
+  {
+    io_session.m_table = std::atomic_load(&m_table);
+  }
+
+  ++io_session.m_position;
+
+  /***** Panic mode: drop input until a synchronizing token arrives *****/
+  if(io_session.m_skipping)
+  {
+    if(!i_token.isEND() && m_syncTokens.find(i_token) == m_syncTokens.end())
+    {
+      ++io_session.m_skipCount;
+      return io_session.m_status;
+    }
+
+    if(!this->synchronize(io_session, i_token))
+    {
+      return io_session.m_status;
+    }
+  }
+
+  io_session.m_status = this->consume(io_session, std::move(i_token), io_handler);
+  return io_session.m_status;
+}
+
+template<typename Handler> ParseSession::Status LRParser::push(ParseSession &io_session, Symbol const * const i_tokens, size_t const i_tokenCount, Handler &io_handler) const
+{
+  for(size_t i=0; i<i_tokenCount && io_session.m_status == ParseSession::Status::NEED_MORE; ++i)
+  {
+    this->push(io_session, Symbol(i_tokens[i]), io_handler);
+  }
+
+  return io_session.m_status;
+}
+
+template<typename Handler> void LRParser::replayChunk(ParallelChunk const &i_chunk, Symbol const * const i_tokens, bool const i_record, ParseSession &io_session, Handler &io_handler) const
+{
+  ParseSession const &chunkSession=i_chunk.session;
+
+  /***** Spans need the caller's stack, so they are worked out here rather than in the chunk *****/
+  if(i_record)
+  {
+    std::vector<size_t> &stackBegin=io_session.m_stackBegin;
+    for(ParallelEvent const &event : i_chunk.events)
+    {
+      if(event.production == ParseTree::TOKEN)
+      {
+        io_handler.shift(i_tokens[event.position], event.position);
+        if(io_session.m_tree != nullptr)
+        {
+          io_session.m_tree->shift(event.position);
+        }
+        stackBegin.push_back(event.position);
+      }
+      else
+      {
+        size_t const popCount=io_session.m_table->productionLength(event.production);
+        size_t const begin=(popCount > 0) ? stackBegin[stackBegin.size()-popCount] : event.position;
+        stackBegin.resize(stackBegin.size()-popCount);
+        io_handler.reduce(event.production, begin, event.position);
+        if(io_session.m_tree != nullptr)
+        {
+          io_session.m_tree->reduce(event.production, popCount, event.position);
+        }
+        stackBegin.push_back(begin);
+      }
+    }
+  }
+
+  /***** The chunk's stack is the real one from here on *****/
+  std::vector<size_t> stackBegin;
+  stackBegin.swap(io_session.m_stackBegin);
+  io_session.assignStack(chunkSession, chunkSession.m_stackState.size());
+  if(i_record)
+  {
+    io_session.m_stackBegin.swap(stackBegin);
+  }
+  io_session.m_position = chunkSession.m_position;
+  io_session.m_status = chunkSession.m_status;
+  if(io_session.m_counting)
+  {
+    io_session.m_shiftCount += chunkSession.m_shiftCount;
+    io_session.m_reduceCount += chunkSession.m_reduceCount;
+    io_session.m_maxDepth = std::max(io_session.m_maxDepth, chunkSession.m_maxDepth);
+  }
+}
+
+template<typename Handler> ParseSession::Status LRParser::consume(ParseSession &io_session, Symbol &&i_token, Handler &io_handler) const
+{
+  LRStateStack &stackState=io_session.m_stackState;
+  SymbolStack &stackSymbol=io_session.m_stackSymbol;
+  std::vector<size_t> &stackBegin=io_session.m_stackBegin;
+  size_t const position=io_session.m_position-1;
+  LRTable const &table=*io_session.m_table;
+  LRTable::Terminal const terminal=table.terminal(i_token);
+
+  while(!stackState.empty())
+  {
+    LRState const state=stackState.back();
+    LRAction const &action=table.action(state, terminal.terminalClass);
+
+    if(io_session.m_trace != nullptr)
+    {
+      io_session.m_trace->record(state, terminal.id, action);
+    }
+
+    if(action.isShift())
+    {
+      io_handler.shift(i_token, position);
+      if(io_session.m_tree != nullptr)
+      {
+        io_session.m_tree->shift(position);
+      }
+      stackSymbol.push_back(std::move(i_token));
+      stackBegin.push_back(position);
+      stackState.push_back(action.state());
+      if(io_session.m_counting)
+      {
+        ++io_session.m_shiftCount;
+        io_session.m_maxDepth = std::max(io_session.m_maxDepth, stackState.size());
+      }
+      return ParseSession::Status::NEED_MORE;
+    }
+    else if(action.isReduce())
+    {
+      uint32_t const productionIndex = action.productionIndex();
+      size_t const popCount = table.productionLength(productionIndex);
+      size_t const begin = (popCount > 0) ? stackBegin[stackBegin.size()-popCount] : position;
+      stackSymbol.erase(stackSymbol.end()-popCount, stackSymbol.end());
+      stackBegin.resize(stackBegin.size()-popCount);
+      stackState.resize(stackState.size()-popCount);
+      if(io_session.m_counting)
+      {
+        ++io_session.m_reduceCount;
+      }
+      io_handler.reduce(productionIndex, begin, position);
+      if(io_session.m_tree != nullptr)
+      {
+        io_session.m_tree->reduce(productionIndex, popCount, position);
+      }
+
+      /***** Land past any unit reductions the path leads into *****/
+      uint32_t reducedIndex = productionIndex;
+      LRState nextState = table.path(stackState.back(), productionIndex);
+      if(m_unitRules != UnitRules::KEEP && table.unitReduction(nextState) != LRTable::NO_PRODUCTION)
+      {
+        LRTable::UnitPath const * const unitPath=table.unitPath(stackState.back(), productionIndex);
+        if(unitPath != nullptr)
+        {
+          for(size_t i=unitPath->stepBegin; i<unitPath->stepEnd; ++i)
+          {
+            LRTable::UnitStep const &step=table.unitStep(i);
+            if(m_unitRules == UnitRules::REPORT)
+            {
+              if(io_session.m_trace != nullptr)
+              {
+                io_session.m_trace->record(step.state, terminal.id, REDUCE(step.productionIndex));
+              }
+              if(io_session.m_counting)
+              {
+                ++io_session.m_reduceCount;
+              }
+              io_handler.reduce(step.productionIndex, begin, position);
+              if(io_session.m_tree != nullptr)
+              {
+                io_session.m_tree->reduce(step.productionIndex, 1, position);
+              }
+            }
+            reducedIndex = step.productionIndex;
+          }
+          nextState = unitPath->state;
+        }
+      }
+      stackSymbol.push_back(table.productionLeft(reducedIndex));
+      stackBegin.push_back(begin);
+      stackState.push_back(nextState);
+      if(io_session.m_counting)
+      {
+        io_session.m_maxDepth = std::max(io_session.m_maxDepth, stackState.size());
+      }
+    }
+    else if(action.isAccept())
+    {
+      return ParseSession::Status::ACCEPTED;
+    }
+    else if(!this->recover(io_session, i_token))
+    {
+      return io_session.m_status;
+    }
+    else
+    {
+      /***** Repairs queue the tokens they insert ahead of i_token *****/
+      SymbolStack insertions;
+      insertions.swap(io_session.m_insertions);
+      for(auto &inserted : insertions)
+      {
+        this->consume(io_session, std::move(inserted), io_handler);
+      }
+    }
+  }
+
+  return ParseSession::Status::ERROR;
+}
+/**************************************************/
+
 #endif /* _LRPARSER_HPP_ */
@@ -2,11 +2,14 @@
 #define _LRSTATE_HPP_
 
 #include <cstddef>
-#include <stack>
+#include <limits>
+#include <vector>
 
 /********************----- CLASS: LRState -----********************/
 typedef std::size_t LRState;
-typedef std::stack<LRState> LRStateStack;
+typedef std::vector<LRState> LRStateStack;
+
+LRState const LRSTATE_INVALID=std::numeric_limits<LRState>::max();
 /**************************************************/
 
 #endif /* _LRSTATE_HPP_ */
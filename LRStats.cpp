@@ -0,0 +1,152 @@
+#include "LRStats.hpp"
+#include "ParseSession.hpp"
+#include "global.hpp"
+
+#include <algorithm>
+
+/********************----- CLASS: LRStats::Timer -----********************/
+LRStats::Timer::Timer(LRStats * const io_stats, Phase const i_phase)
+:m_stats(io_stats), m_phase(i_phase)
+{
+  if(m_stats != nullptr)
+  {
+    m_start = std::chrono::steady_clock::now();
+  }
+}
+
+LRStats::Timer::~Timer()
+{
+  if(m_stats != nullptr)
+  {
+    m_stats->addTime(m_phase, std::chrono::steady_clock::now()-m_start);
+  }
+}
+/**************************************************/
+
+/********************----- CLASS: LRStats -----********************/
+LRStats::LRStats()
+{
+  this->clear();
+}
+
+void LRStats::add(Counter const i_counter, size_t const i_amount)
+{
+  m_counters[enum_value(i_counter)] += i_amount;
+}
+
+void LRStats::addParse(ParseSession const &i_session)
+{
+  this->add(Counter::PARSES);
+  this->add(Counter::TOKENS, i_session.position());
+  this->add(Counter::SHIFTS, i_session.shiftCount());
+  this->add(Counter::REDUCES, i_session.reduceCount());
+  this->add(Counter::ERRORS, i_session.errors().size());
+  m_maxDepth = std::max(m_maxDepth, i_session.maxDepth());
+}
+
+void LRStats::addTime(Phase const i_phase, std::chrono::steady_clock::duration const &i_duration)
+{
+  m_phaseTimes[enum_value(i_phase)] += i_duration;
+}
+
+void LRStats::clear()
+{
+  std::fill(m_phaseTimes, m_phaseTimes+enum_value(Phase::COUNT), std::chrono::steady_clock::duration::zero());
+  std::fill(m_counters, m_counters+enum_value(Counter::COUNT), 0);
+  m_maxDepth = 0;
+}
+
+size_t LRStats::count(Counter const i_counter) const
+{
+  return m_counters[enum_value(i_counter)];
+}
+
+size_t LRStats::maxDepth() const
+{
+  return m_maxDepth;
+}
+
+char const *LRStats::name(Counter const i_counter)
+{
+  switch(i_counter)
+  {
+    case Counter::CLOSURE_CALLS:
+      return "closure_calls";
+    case Counter::CLOSURE_ITERATIONS:
+      return "closure_iterations";
+    case Counter::CLOSURE_ITEMS:
+      return "closure_items";
+    case Counter::CLOSURE_CACHE_HITS:
+      return "closure_cache_hits";
+    case Counter::CLOSURE_CACHE_MISSES:
+      return "closure_cache_misses";
+    case Counter::KERNEL_LOOKUPS:
+      return "kernel_lookups";
+    case Counter::STATES_RECLOSED:
+      return "states_reclosed";
+    case Counter::CONFLICTS_RESOLVED:
+      return "conflicts_resolved";
+    case Counter::PARSES:
+      return "parses";
+    case Counter::TOKENS:
+      return "tokens";
+    case Counter::SHIFTS:
+      return "shifts";
+    case Counter::REDUCES:
+      return "reduces";
+    case Counter::ERRORS:
+      return "errors";
+    default:
+      return "?";
+  }
+}
+
+char const *LRStats::name(Phase const i_phase)
+{
+  switch(i_phase)
+  {
+    case Phase::FIRST:
+      return "first";
+    case Phase::FOLLOW:
+      return "follow";
+    case Phase::CLOSURE:
+      return "closure";
+    case Phase::STATES:
+      return "states";
+    case Phase::TABLE:
+      return "table";
+    default:
+      return "?";
+  }
+}
+
+double LRStats::seconds(Phase const i_phase) const
+{
+  return std::chrono::duration<double>(m_phaseTimes[enum_value(i_phase)]).count();
+}
+
+std::string LRStats::toJSON() const
+{
+  //Closure and table time are also part of the states phase that calls them
+  std::string outputString="{\"seconds\":{";
+  for(size_t i=0; i<size_t(enum_value(Phase::COUNT)); ++i)
+  {
+    Phase const phase=static_cast<Phase>(i);
+    if(i != 0)
+    {
+      outputString += ",";
+    }
+    outputString += "\"" + std::string(LRStats::name(phase)) + "\":" + std::to_string(this->seconds(phase));
+  }
+
+  outputString += "},\"counters\":{";
+  for(size_t i=0; i<size_t(enum_value(Counter::COUNT)); ++i)
+  {
+    Counter const counter=static_cast<Counter>(i);
+    outputString += "\"" + std::string(LRStats::name(counter)) + "\":" + std::to_string(this->count(counter)) + ",";
+  }
+  outputString += "\"max_depth\":" + std::to_string(m_maxDepth) + "}}";
+
+  return outputString;
+}
+/**************************************************/
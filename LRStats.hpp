@@ -0,0 +1,85 @@
+#ifndef _LRSTATS_HPP_
+#define _LRSTATS_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+class ParseSession;
+
+/********************----- CLASS: LRStats -----********************/
+//Optional construction and parse statistics. Builders take an LRStats
+//pointer and skip all bookkeeping (including clock reads) when it is null.
+//Parse counters are taken from sessions that have counting switched on,
+//see ParseSession::setCounting().
+class LRStats
+{
+public:
+  enum class Phase
+  {
+    FIRST,
+    FOLLOW,
+    CLOSURE,
+    STATES,
+    TABLE,
+    COUNT,
+  };
+
+  enum class Counter
+  {
+    CLOSURE_CALLS,
+    CLOSURE_ITERATIONS,
+    CLOSURE_ITEMS,
+    CLOSURE_CACHE_HITS,
+    CLOSURE_CACHE_MISSES,
+    KERNEL_LOOKUPS,
+    STATES_RECLOSED,
+    CONFLICTS_RESOLVED,
+    PARSES,
+    TOKENS,
+    SHIFTS,
+    REDUCES,
+    ERRORS,
+    COUNT,
+  };
+
+  /********************----- CLASS: LRStats::Timer -----********************/
+  //Adds the lifetime of the timer to a phase
+  class Timer
+  {
+  public:
+    Timer(LRStats * const io_stats, Phase const i_phase);
+    ~Timer();
+  private:
+    Timer(Timer const &)=delete;
+    Timer &operator =(Timer const &)=delete;
+
+    LRStats *m_stats;
+    Phase m_phase;
+    std::chrono::steady_clock::time_point m_start;
+  };
+  /**************************************************/
+
+  LRStats();
+
+  void add(Counter const i_counter, size_t const i_amount=1);
+  void addParse(ParseSession const &i_session);
+  void addTime(Phase const i_phase, std::chrono::steady_clock::duration const &i_duration);
+  void clear();
+
+  size_t count(Counter const i_counter) const;
+  size_t maxDepth() const;
+  double seconds(Phase const i_phase) const;
+
+  std::string toJSON() const;
+
+  static char const *name(Counter const i_counter);
+  static char const *name(Phase const i_phase);
+private:
+  std::chrono::steady_clock::duration m_phaseTimes[static_cast<size_t>(Phase::COUNT)];
+  size_t m_counters[static_cast<size_t>(Counter::COUNT)];
+  size_t m_maxDepth;
+};
+/**************************************************/
+
+#endif /* _LRSTATS_HPP_ */
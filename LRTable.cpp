@@ -1,373 +1,794 @@
 #include "LRTable.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
+#include <limits>
+#include <numeric>
 
-/********************----- CLASS: LRTable -----********************/
-LRTable::LRTable(LRTable::Type const i_type, Grammar const &i_grammar)
-:m_type(i_type)
+/********************----- Helper Functions -----********************/
+//Names a conflict by its kinds of actions, shifts first, as yacc does
+static std::string conflictName(LRAction const &i_action, LRAction const &i_otherAction)
+{
+  static char const * const kindNames[]={"accept", "error", "reduce", "shift"};
+  static unsigned const kindRanks[]={1, 3, 2, 0};
+  unsigned const kind=unsigned(i_action.type());
+  unsigned const otherKind=unsigned(i_otherAction.type());
+  if(kindRanks[otherKind] < kindRanks[kind])
+  {
+    return std::string(kindNames[otherKind]) + "/" + kindNames[kind];
+  }
+
+  return std::string(kindNames[kind]) + "/" + kindNames[otherKind];
+}
+
+//update() keeps states whose items name old production and symbol IDs, so
+//every old symbol and production has to keep its ID, rule and precedence
+static bool extendsGrammar(CompiledGrammar const &i_oldGrammar, CompiledGrammar const &i_grammar)
 {
-  Grammar const &g=i_grammar;
+  if(i_grammar.symbolCount() < i_oldGrammar.symbolCount() || i_grammar.productionCount() < i_oldGrammar.productionCount() || i_grammar.startSymbol() != i_oldGrammar.startSymbol())
+  {
+    return false;
+  }
+
+  for(SymbolId i=0; i<i_oldGrammar.symbolCount(); ++i)
+  {
+    if(!(i_grammar.symbol(i) == i_oldGrammar.symbol(i)) || i_grammar.precedence(i) != i_oldGrammar.precedence(i) || i_grammar.associativity(i) != i_oldGrammar.associativity(i))
+    {
+      return false;
+    }
+  }
+
+  for(size_t i=0; i<i_oldGrammar.productionCount(); ++i)
+  {
+    if(i_grammar.productionLeft(i) != i_oldGrammar.productionLeft(i) || i_grammar.productionLength(i) != i_oldGrammar.productionLength(i) ||
+       !std::equal(i_oldGrammar.productionRight(i), i_oldGrammar.productionRight(i)+i_oldGrammar.productionLength(i), i_grammar.productionRight(i)) ||
+       i_grammar.productionPrecedence(i) != i_oldGrammar.productionPrecedence(i))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static std::string typeName(LRTable::Type const i_type)
+{
+  switch(i_type)
+  {
+  case LRTable::Type::GLR:
+    return "GLR";
+  case LRTable::Type::LALR:
+    return "LALR(1)";
+  case LRTable::Type::LR:
+    return "LR(1)";
+  case LRTable::Type::LR0:
+    return "LR(0)";
+  case LRTable::Type::SLR:
+    return "SLR(1)";
+  }
+
+  return "";
+}
+/**************************************************/
 
+/********************----- CLASS: LRTable -----********************/
+LRTable::TerminalClass const LRTable::NO_CLASS;
+uint32_t const LRTable::NO_PRODUCTION;
+uint32_t const LRTable::ACTION_ERROR;
+
+LRTable::LRTable(LRTable::Type const i_type, Grammar const &i_grammar, LRStats * const io_stats)
+:m_type(i_type), m_closureCache(LRTable::CLOSURE_CACHE_CAPACITY), m_lookaheadWords(0)
+{
   /***** Check that grammar is context-free *****/
-  if(!g.isContextFree())
+  if(!i_grammar.isContextFree())
   {
     throw std::logic_error("Grammar is not context-free");
   }
 
-  /***** Build items *****/
-  LRItemSetVector states;
-  switch(i_type)
+  /***** Compile with the grammar's own IDs, which update() relies on *****/
+  m_grammar.reset(new CompiledGrammar(i_grammar, CompiledGrammar::Numbering::GRAMMAR, io_stats));
+
+  this->build(*m_grammar, io_stats);
+}
+
+LRTable::LRTable(LRTable::Type const i_type, CompiledGrammar const &i_grammar, LRStats * const io_stats)
+:m_type(i_type), m_closureCache(LRTable::CLOSURE_CACHE_CAPACITY), m_lookaheadWords(0)
+{
+  this->build(i_grammar, io_stats);
+}
+
+LRTable::LRTable(LRTable const &i_table)
+:m_actions(i_table.m_actions), m_paths(i_table.m_paths), m_type(i_table.m_type), m_closureCache(LRTable::CLOSURE_CACHE_CAPACITY),
+ m_kernelStates(i_table.m_kernelStates), m_mergedKernels(i_table.m_mergedKernels), m_kernels(i_table.m_kernels.size(), nullptr),
+ m_closureHashes(i_table.m_closureHashes), m_terminalBits(i_table.m_terminalBits),
+ m_lookaheadWords(i_table.m_lookaheadWords), m_grammar(i_table.m_grammar), m_terminals(i_table.m_terminals),
+ m_actionPool(i_table.m_actionPool), m_actionDefaults(i_table.m_actionDefaults), m_actionRows(i_table.m_actionRows),
+ m_actionComb(i_table.m_actionComb), m_pathColumns(i_table.m_pathColumns), m_productionLefts(i_table.m_productionLefts),
+ m_productionLengths(i_table.m_productionLengths), m_pathRows(i_table.m_pathRows), m_pathComb(i_table.m_pathComb),
+ m_unitReductions(i_table.m_unitReductions), m_unitPaths(i_table.m_unitPaths), m_unitSteps(i_table.m_unitSteps),
+ m_unitComb(i_table.m_unitComb)
+{
+  /***** Point the kernels at this table's copies of them *****/
+  //LALR keeps state i's merged kernel at m_mergedKernels[i]; the other
+  //types key m_kernelStates by the kernels themselves
+  if(m_type == Type::LALR)
   {
-  case Type::LALR:
-    states=LRTable::buildLALRItems(g);
-    break;
-  case Type::LR:
-    states=LRTable::buildLRItems(g);
-    break;
+    for(size_t i=0; i<m_kernels.size(); ++i)
+    {
+      m_kernels[i] = &m_mergedKernels[i];
+    }
+  }
+  else
+  {
+    for(KernelMap::value_type const &kernelPair : m_kernelStates)
+    {
+      m_kernels[kernelPair.second] = &kernelPair.first;
+    }
   }
-  if(states.empty())
+}
+
+LRAction LRTable::action(LRState const &i_currentState, SymbolList const &i_symbolList) const
+{
+  if(i_currentState >= m_actions.size())
   {
-    throw std::range_error("No items built from grammar.");
+    return ERROR();
   }
 
-  /***** Populate table *****/
-  for(size_t i=0; i<states.size(); ++i)
+  std::pair<ActionRow::const_iterator, ActionRow::const_iterator> actionPair = m_actions[i_currentState].equal_range(i_symbolList);
+
+  /***** Nothing; compress() rejects rows with more than one *****/
+  if(actionPair.first == actionPair.second)
   {
-    /***** Build actions *****/
-    for(LRItemSet::const_iterator isit=states[i].begin(); isit!=states[i].end(); ++isit)
+    return ERROR();
+  }
+
+  return actionPair.first->second;
+}
+
+void LRTable::build(CompiledGrammar const &i_grammar, LRStats * const io_stats)
+{
+  CompiledGrammar const &g=i_grammar;
+
+  /***** Build items *****/
+  switch(m_type)
+  {
+  case Type::GLR:
+    throw std::logic_error("GLR tables are not supported");
+  case Type::LALR:
+  case Type::LR:
+  case Type::LR0:
+  case Type::SLR:
     {
-      SymbolList const &right=isit->production().right();
-      if(isit->rightPosition() < right.count() && right[isit->rightPosition()].isTerminal())
+      //LR0 and SLR build the LR(0) automaton, whose items carry no lookaheads,
+      //and reduce on every terminal or on FOLLOW of the production's left side.
+      //LALR builds the LR(1) automaton but merges states with the same cores
+      if(g.productionCount() == 0)
       {
-        Symbol const &nextSymbol = right[isit->rightPosition()];
-        LRItemSet const currentPath=this->computePaths(states[i], nextSymbol, i_grammar);
-        for(size_t j=0; j<states.size(); ++j)
+        throw std::range_error("No items built from grammar.");
+      }
+      LRItem::checkLimits(g);
+      LRAction::checkLimits(g);
+      m_lookaheadWords = g.setWords();
+      if(m_type == Type::LR0)
+      {
+        m_terminalBits.assign(m_lookaheadWords, 0);
+        for(SymbolId i=0; i<g.symbolCount(); ++i)
         {
-          if(currentPath == states[j])
+          if(g.isTerminal(i) && i != CompiledGrammar::EPSILON_ID)
           {
-            this->insertAction(LRState(i), nextSymbol, SHIFT(LRState(j)));
+            m_terminalBits[i/64] |= uint64_t(1) << (i%64);
           }
         }
       }
-      else if(isit->rightPosition() >= right.count() && isit->lookahead() == END() && isit->production().left()[0] == i_grammar.startSymbol())
-      {
-        this->insertAction(LRState(i), END(), ACCEPT());
-      }
-      else if(isit->rightPosition() >= right.count())
-      {
-        this->insertAction(LRState(i), isit->lookahead(), REDUCE(&isit->production()));
-      }
-    }
 
-    /***** Build paths *****/
-    for(SymbolSet::const_iterator ait=i_grammar.alphabetBegin(); ait!=i_grammar.alphabetEnd(); ++ait)
-    {
-      if(ait->isNonterminal())
+      LRStats::Timer timer(io_stats, LRStats::Phase::STATES);
+      LRItemSet startState(this->itemLookaheadWords());
+      size_t const startIndex=startState.add(LRItem(0, 0));
+      if(this->itemLookaheadWords() != 0)
       {
-        LRItemSet const currentPath=this->computePaths(states[i], *ait, i_grammar);
-        for(size_t j=0; j<states.size(); ++j)
-        {
-          if(currentPath == states[j])
-          {
-            this->insertPath(LRState(i),*ait, LRState(j));
-          }
-        }
+        startState.addLookahead(startIndex, CompiledGrammar::END_ID);
       }
+      bool queued=false;
+      std::vector<LRState> pendingStates={this->insertState(std::move(startState), queued)};
+      this->buildLRItems(pendingStates, g, io_stats);
     }
+    break;
   }
+  m_closureCache.clear();
+  this->compress(g);
 
 #ifndef NDEBUG
-  std::cout << this->toString() << std::endl;
+  std::cout << this->toString(g) << std::endl;
 #endif
 }
 
-LRAction LRTable::action(LRState const &i_currentState, SymbolList const &i_symbolList) const
+void LRTable::buildLRItems(std::vector<LRState> &io_pendingStates, CompiledGrammar const &i_grammar, LRStats * const io_stats)
 {
-  std::pair<ActionRow::const_iterator, ActionRow::const_iterator> actionPair = m_actions.at(i_currentState).equal_range(i_symbolList);
-
-  /***** Nothing *****/
-  if(actionPair.first == actionPair.second)
+  //Only kernels are kept; each closure lives just long enough to fill its
+  //row, and unseen kernels it reaches are queued behind it
+  for(size_t i=0; i<io_pendingStates.size(); ++i)
   {
-    throw std::out_of_range(i_symbolList.toString());
+    LRState const state=io_pendingStates[i];
+    LRItemSet stateItems=this->closure(*m_kernels[state], i_grammar, io_stats);
+    m_closureHashes[state] = stateItems.hash();
+
+#ifndef NDEBUG
+    printItemSet("State " + std::to_string(state), stateItems, i_grammar);
+#endif
+
+    this->fillState(state, stateItems, i_grammar, io_stats, io_pendingStates);
   }
+}
+
+LRItemSet LRTable::closure(LRItemSet const &i_kernelItems, CompiledGrammar const &i_grammar, LRStats * const io_stats) const
+{
+  LRStats::Timer timer(io_stats, LRStats::Phase::CLOSURE);
+  size_t iterationCount=0;
 
-  /***** More than one ******/
-  ActionRow::const_iterator actionNext = actionPair.first;
-  ++actionNext;
-  if(actionNext != actionPair.second)
+  /***** Find or build the shape shared by every kernel with these cores *****/
+  LRItemSet kernelCores;
+  for(size_t i=0; i<i_kernelItems.size(); ++i)
   {
-    throw std::range_error("Shift/Shift conflict");
+    kernelCores.add(i_kernelItems.item(i));
   }
 
-  return actionPair.first->second;
-}
+  LRClosureCache::Entry const *shape=m_closureCache.find(kernelCores);
+  if(io_stats != nullptr)
+  {
+    io_stats->add((shape != nullptr) ? LRStats::Counter::CLOSURE_CACHE_HITS : LRStats::Counter::CLOSURE_CACHE_MISSES);
+  }
+  if(shape == nullptr)
+  {
+    LRClosureCache::Entry builtShape=this->closureShape(kernelCores, i_grammar, iterationCount);
+    shape = &m_closureCache.insert(std::move(kernelCores), std::move(builtShape));
+  }
 
-LRItemSet LRTable::computeKernelItems(LRItemSet const &i_kernelItems, LRItemSet const &i_nonkernelItems, Grammar const &i_grammar)
-{
-  LRItemSet outputItems;
+  /***** Pass the kernel's own lookaheads along the shape's edges *****/
+  LRItemSet outputSet(shape->items);
+  std::vector<size_t> pendingItems;
+  std::vector<bool> queuedItems(outputSet.size(), false);
+  for(size_t i=0; i<i_kernelItems.size(); ++i)
+  {
+    size_t const itemIndex=shape->kernelIndices[i];
+    outputSet.addLookaheads(itemIndex, i_kernelItems.lookaheads(i));
+    queuedItems[itemIndex] = true;
+    pendingItems.push_back(itemIndex);
+  }
 
-  for(LRItemSet::const_iterator kit=i_kernelItems.begin(); kit!=i_kernelItems.end(); ++kit)
+  while(!pendingItems.empty())
   {
-    SymbolList const &right=kit->production().right();
-    if(kit->rightPosition() < right.count())
+    size_t const currentIndex=pendingItems.back();
+    pendingItems.pop_back();
+    queuedItems[currentIndex] = false;
+    ++iterationCount;
+
+    for(size_t e=shape->edgeOffsets[currentIndex]; e<shape->edgeOffsets[currentIndex+1]; ++e)
     {
-      outputItems.insert(LRItem(&kit->production(), kit->rightPosition()+1, kit->lookahead()));
+      size_t const targetIndex=shape->edgeTargets[e];
+      if(outputSet.addLookaheads(targetIndex, outputSet.lookaheads(currentIndex)) && !queuedItems[targetIndex])
+      {
+        queuedItems[targetIndex] = true;
+        pendingItems.push_back(targetIndex);
+      }
     }
   }
 
-  for(LRItemSet::const_iterator nit=i_nonkernelItems.begin(); nit!=i_nonkernelItems.end(); ++nit)
+  if(io_stats != nullptr)
   {
-    SymbolList const &right=nit->production().right();
-    if(nit->rightPosition() < right.count())
-    {
-      outputItems.insert(LRItem(&nit->production(), nit->rightPosition()+1, nit->lookahead()));
-    }
+    io_stats->add(LRStats::Counter::CLOSURE_CALLS);
+    io_stats->add(LRStats::Counter::CLOSURE_ITERATIONS, iterationCount);
+    io_stats->add(LRStats::Counter::CLOSURE_ITEMS, outputSet.size());
   }
 
-  return outputItems;
+  return outputSet;
 }
 
-LRItemSet LRTable::computeNonkernelItems(LRItemSet const &i_kernelItems, Grammar const &i_grammar)
+LRClosureCache::Entry LRTable::closureShape(LRItemSet const &i_kernelCores, CompiledGrammar const &i_grammar, size_t &io_iterationCount) const
 {
-  LRItemSet nonkernelItems;
-
-  /***** Generate items from kernel items *****/
-  for(LRItemSet::const_iterator kit=i_kernelItems.begin(); kit!=i_kernelItems.end(); ++kit)
+  size_t const itemWords=this->itemLookaheadWords();
+  LRItemSet shapeItems(itemWords);
+  std::vector<std::vector<size_t>> edges(i_kernelCores.size());
+
+  /***** Index the item [B ::= . y] of each production once it exists *****/
+  size_t const NO_ITEM=std::numeric_limits<size_t>::max();
+  std::vector<size_t> predictedItems(i_grammar.productionCount(), NO_ITEM);
+  for(size_t i=0; i<i_kernelCores.size(); ++i)
   {
-    SymbolList const &right=kit->production().right();
-    if(kit->rightPosition() >= right.count())
+    size_t const itemIndex=shapeItems.add(i_kernelCores.item(i));
+    if(i_kernelCores.item(i).rightPosition() == 0)
     {
-      continue;
+      predictedItems[i_kernelCores.item(i).production()] = itemIndex;
     }
+  }
 
-    Symbol const &nextSymbol = right[kit->rightPosition()];
-    if(!nextSymbol.isNonterminal())
+  //An item [A ::= x . B y] gives every [B ::= . z] FIRST(y), and its own
+  //lookaheads too when y is nullable; the latter become edges
+  std::vector<uint64_t> firstBits(itemWords);
+  for(size_t i=0; i<shapeItems.size(); ++i)
+  {
+    ++io_iterationCount;
+    LRItem const currentItem=shapeItems.item(i);
+    SymbolId const * const currentRight=i_grammar.productionRight(currentItem.production());
+    size_t const currentLength=i_grammar.productionLength(currentItem.production());
+    if(currentItem.rightPosition() >= currentLength)
     {
       continue;
     }
 
-    ProductionConstPtrVector productionPointers=i_grammar.productionPointers(nextSymbol);
-    if(productionPointers.empty())
+    SymbolId const nextSymbol=currentRight[currentItem.rightPosition()];
+    if(i_grammar.productionsBegin(nextSymbol) == i_grammar.productionsEnd(nextSymbol))
     {
       continue;
     }
 
-    for(Production const *p: productionPointers)
+    std::fill(firstBits.begin(), firstBits.end(), 0);
+    bool const nullable=(itemWords != 0) && i_grammar.firstList(currentRight+currentItem.rightPosition()+1, currentRight+currentLength, firstBits.data());
+    for(uint32_t const *pit=i_grammar.productionsBegin(nextSymbol); pit!=i_grammar.productionsEnd(nextSymbol); ++pit)
     {
-      nonkernelItems.insert(LRItem(p, 0));
+      size_t const productionIndex=*pit;
+      size_t &predictedIndex=predictedItems[productionIndex];
+      if(predictedIndex == NO_ITEM)
+      {
+        predictedIndex = shapeItems.add(LRItem(productionIndex, 0));
+        edges.emplace_back();
+      }
+      shapeItems.addLookaheads(predictedIndex, firstBits.data());
+      if(nullable)
+      {
+        edges[i].push_back(predictedIndex);
+      }
     }
   }
 
-  /***** Generate items from previously generated items *****/
-  bool itemAdded = true;
-  while(itemAdded)
+  /***** Settle the FIRST lookaheads along the edges *****/
+  bool lookaheadAdded=true;
+  while(lookaheadAdded)
   {
-    itemAdded = false;
-
-    for(LRItemSet::const_iterator nit=nonkernelItems.begin(); nit!=nonkernelItems.end(); ++nit)
+    lookaheadAdded = false;
+    for(size_t i=0; i<edges.size(); ++i)
     {
-      /***** Check if end of rule *****/
-      SymbolList const &right=nit->production().right();
-      if(nit->rightPosition() >= right.count())
+      for(size_t const targetIndex : edges[i])
       {
-        continue;
+        lookaheadAdded = shapeItems.addLookaheads(targetIndex, shapeItems.lookaheads(i)) || lookaheadAdded;
       }
+    }
+  }
+
+  /***** Sort the cores, renumbering the kernel positions and edges *****/
+  std::vector<size_t> order(shapeItems.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&shapeItems](size_t const i_a, size_t const i_b){return shapeItems.item(i_a) < shapeItems.item(i_b);});
+  std::vector<size_t> rank(order.size());
+  for(size_t i=0; i<order.size(); ++i)
+  {
+    rank[order[i]] = i;
+  }
+
+  LRClosureCache::Entry shape;
+  shape.items = LRItemSet(itemWords);
+  for(size_t const oldIndex : order)
+  {
+    shape.items.addLookaheads(shape.items.add(shapeItems.item(oldIndex)), shapeItems.lookaheads(oldIndex));
+    shape.edgeOffsets.push_back(shape.edgeTargets.size());
+    for(size_t const targetIndex : edges[oldIndex])
+    {
+      shape.edgeTargets.push_back(rank[targetIndex]);
+    }
+  }
+  shape.edgeOffsets.push_back(shape.edgeTargets.size());
+  for(size_t i=0; i<i_kernelCores.size(); ++i)
+  {
+    shape.kernelIndices.push_back(rank[i]);
+  }
 
-      /***** Get next symbol, if nonterminal *****/
-      Symbol const &nextSymbol = right[nit->rightPosition()];
-      if(!nextSymbol.isNonterminal())
+  return shape;
+}
+
+void LRTable::compress(CompiledGrammar const &i_grammar)
+{
+  //The exact rows stay for recovery, expected() and updates; parsing reads
+  //these instead. Each state reduces by its most common reduction when no
+  //other entry applies, terminals with identical columns share a class,
+  //identical rows are stored once, and the rows are packed by displacement.
+  //Conflicts that precedence did not settle make the table unusable, so
+  //they are all reported at once instead of being stored
+  CompiledGrammar const &g=i_grammar;
+  size_t const rowCount=std::max(m_kernels.size(), std::max(m_actions.size(), m_paths.size()));
+
+  m_productionLefts.clear();
+  m_productionLengths.clear();
+  for(size_t i=0; i<g.productionCount(); ++i)
+  {
+    m_productionLefts.push_back(g.symbol(g.productionLeft(i)));
+    m_productionLengths.push_back(uint32_t(g.productionLength(i)));
+  }
+
+  /***** Number the distinct actions and index rows by symbol *****/
+  m_actionPool = {ERROR()};
+  std::map<LRAction, uint32_t> actionIndices;
+  std::vector<CombVector::Row> actionRows(rowCount);
+  m_actionDefaults.assign(rowCount, ACTION_ERROR);
+  std::vector<std::string> conflicts;
+  for(size_t s=0; s<m_actions.size(); ++s)
+  {
+    std::map<uint32_t, uint32_t> cells;
+    std::map<uint32_t, size_t> reduceCounts;
+    for(ActionRow::const_iterator ait=m_actions[s].begin(); ait!=m_actions[s].end(); ++ait)
+    {
+      LRAction const &action=ait->second;
+      std::pair<std::map<LRAction, uint32_t>::iterator, bool> const pooled=actionIndices.insert(std::make_pair(action, uint32_t(m_actionPool.size())));
+      if(pooled.second)
       {
-        continue;
+        m_actionPool.push_back(action);
       }
 
-      /***** Find production rules *****/
-      ProductionConstPtrVector productionPointers=i_grammar.productionPointers(nextSymbol);
-      if(productionPointers.empty())
+      std::pair<std::map<uint32_t, uint32_t>::iterator, bool> const cell=cells.insert(std::make_pair(g.symbolId(ait->first[0]), pooled.first->second));
+      if(!cell.second && cell.first->second != pooled.first->second)
       {
-        continue;
+        LRAction const &otherAction=m_actionPool[cell.first->second];
+        conflicts.push_back(conflictName(otherAction, action) + " conflict in state " + std::to_string(s) + " on " + ait->first.toString()
+          + ": " + otherAction.toString(g) + " or " + action.toString(g));
       }
+    }
 
-      /***** Maybe insert production rules *****/
-      for(Production const *p:productionPointers)
+    for(std::map<uint32_t, uint32_t>::const_iterator cit=cells.begin(); cit!=cells.end(); ++cit)
+    {
+      if(m_actionPool[cit->second].isReduce())
       {
-        /***** Check if item exists *****/
-        LRItem item(p, 0);
-        if(nonkernelItems.find(item) != nonkernelItems.end())
+        size_t const count=++reduceCounts[cit->second];
+        if(m_actionDefaults[s] == ACTION_ERROR || count > reduceCounts[m_actionDefaults[s]])
         {
-          continue;
+          m_actionDefaults[s] = cit->second;
         }
-      
-        /***** Insert item *****/
-        nonkernelItems.insert(std::move(item));
-        itemAdded = true;
       }
     }
-  }
 
-  /***** Return *****/
-  return nonkernelItems;
-}
+    for(std::map<uint32_t, uint32_t>::const_iterator cit=cells.begin(); cit!=cells.end(); ++cit)
+    {
+      if(cit->second != m_actionDefaults[s])
+      {
+        actionRows[s].push_back(*cit);
+      }
+    }
+  }
+  if(!conflicts.empty())
+  {
+    std::string message="Grammar is not " + typeName(m_type) + ": " + std::to_string(conflicts.size()) + " conflict" + ((conflicts.size() == 1) ? "" : "s");
+    for(std::string const &conflict : conflicts)
+    {
+      message += "\n" + conflict;
+    }
+    throw std::logic_error(message);
+  }
 
-LRItemSetVector LRTable::buildLALRItems(Grammar const &i_grammar)
-{
-  std::vector<LRItemSet> outputItems;
+  /***** A state whose only action is a chain reduction A ::= B can be skipped *****/
+  m_unitReductions.assign(rowCount, NO_PRODUCTION);
+  for(size_t s=0; s<actionRows.size(); ++s)
+  {
+    LRAction const &defaultAction=m_actionPool[m_actionDefaults[s]];
+    if(actionRows[s].empty() && defaultAction.isReduce())
+    {
+      uint32_t const productionIndex=defaultAction.productionIndex();
+      if(g.productionLength(productionIndex) == 1 && !g.isTerminal(g.productionRight(productionIndex)[0]))
+      {
+        m_unitReductions[s] = defaultAction.productionIndex();
+      }
+    }
+  }
 
-  bool itemAdded=true;
-  size_t iteration=0;
-  LRItemSet kernelItems;
-  LRItemSet nonkernelItems;
-  while(itemAdded)
+  /***** Terminals with the same column in every row form one class *****/
+  std::vector<CombVector::Row> columns(g.symbolCount());
+  for(size_t s=0; s<actionRows.size(); ++s)
   {
-    /***** Build kernel items *****/
-    if(iteration == 0)
+    for(CombVector::Row::const_iterator rit=actionRows[s].begin(); rit!=actionRows[s].end(); ++rit)
     {
-      kernelItems.insert(LRItem(&i_grammar[0], 0, END()));
+      columns[rit->first].push_back(std::make_pair(uint32_t(s), rit->second));
     }
-    else
+  }
+
+  std::map<CombVector::Row, TerminalClass> classIndices;
+  std::vector<TerminalClass> symbolClasses(g.symbolCount(), NO_CLASS);
+  m_terminals.clear();
+  for(SymbolId i=0; i<g.symbolCount(); ++i)
+  {
+    if(!g.isTerminal(i))
     {
-      kernelItems = LRTable::computeKernelItems(kernelItems, nonkernelItems, i_grammar);
+      continue;
     }
 
-    /***** Build nonkernel items *****/
-    nonkernelItems = LRTable::computeNonkernelItems(kernelItems, i_grammar);
+    if(!columns[i].empty())
+    {
+      symbolClasses[i] = classIndices.insert(std::make_pair(columns[i], TerminalClass(classIndices.size()))).first->second;
+    }
+    m_terminals[g.symbol(i)] = Terminal{i, symbolClasses[i]};
+  }
 
-    /***** Store them *****/
-    outputItems[iteration].insert(kernelItems.begin(), kernelItems.end());
-    outputItems[iteration].insert(nonkernelItems.begin(), nonkernelItems.end());
+  /***** Store each distinct row once *****/
+  std::map<CombVector::Row, uint32_t> rowIndices;
+  std::vector<CombVector::Row> distinctRows;
+  m_actionRows.resize(rowCount);
+  for(size_t s=0; s<actionRows.size(); ++s)
+  {
+    CombVector::Row classRow;
+    for(CombVector::Row::const_iterator rit=actionRows[s].begin(); rit!=actionRows[s].end(); ++rit)
+    {
+      classRow.push_back(std::make_pair(symbolClasses[rit->first], rit->second));
+    }
+    std::sort(classRow.begin(), classRow.end());
+    classRow.erase(std::unique(classRow.begin(), classRow.end()), classRow.end());
 
-    ++iteration;
+    std::pair<std::map<CombVector::Row, uint32_t>::iterator, bool> const row=rowIndices.insert(std::make_pair(classRow, uint32_t(distinctRows.size())));
+    if(row.second)
+    {
+      distinctRows.push_back(std::move(classRow));
+    }
+    m_actionRows[s] = row.first->second;
   }
+  m_actionComb.pack(distinctRows, classIndices.size());
 
-  return outputItems;
-}
-
-LRItemSetVector LRTable::buildLRItems(Grammar const &i_grammar)
-{
-  std::vector<LRItemSet> states;
+  /***** Paths are indexed by the reduced production's left side *****/
+  std::vector<uint32_t> symbolColumns(g.symbolCount(), CombVector::NO_VALUE);
+  uint32_t columnCount=0;
+  for(SymbolId i=0; i<g.symbolCount(); ++i)
+  {
+    if(!g.isTerminal(i))
+    {
+      symbolColumns[i] = columnCount++;
+    }
+  }
 
-  /***** Do start state *****/
-  LRItemSet const startState = {LRItem(&i_grammar[0], 0, END())};
-  LRItemSet const startStateClosure = LRTable::closure(startState, i_grammar);
-  states.push_back(startStateClosure);
+  m_pathColumns.clear();
+  for(size_t i=0; i<g.productionCount(); ++i)
+  {
+    m_pathColumns.push_back(symbolColumns[g.productionLeft(i)]);
+  }
 
-  bool itemAdded = true;
-  while(itemAdded)
+  rowIndices.clear();
+  distinctRows.clear();
+  m_pathRows.assign(rowCount, 0);
+  m_unitPaths.clear();
+  m_unitSteps.clear();
+  std::vector<CombVector::Row> unitRows;
+  for(size_t s=0; s<m_paths.size(); ++s)
   {
-    itemAdded = false;
-    for(size_t i=0; i<states.size(); ++i)
+    std::map<uint32_t, uint32_t> cells;
+    for(PathRow::const_iterator pit=m_paths[s].begin(); pit!=m_paths[s].end(); ++pit)
     {
-      LRItemSet const &sourceState=states[i];
-      for(SymbolSet::const_iterator ait=i_grammar.alphabetBegin(); ait!=i_grammar.alphabetEnd(); ++ait)
+      cells.insert(std::make_pair(symbolColumns[g.symbolId(pit->first[0])], uint32_t(pit->second)));
+    }
+
+    CombVector::Row pathRow(cells.begin(), cells.end());
+    std::pair<std::map<CombVector::Row, uint32_t>::iterator, bool> const row=rowIndices.insert(std::make_pair(pathRow, uint32_t(distinctRows.size())));
+    if(row.second)
+    {
+      distinctRows.push_back(std::move(pathRow));
+
+      //Follow each path through the unit reductions it leads into; the chain
+      //only depends on this row, so rows shared by several states share it
+      unitRows.emplace_back();
+      for(std::map<uint32_t, uint32_t>::const_iterator cit=cells.begin(); cit!=cells.end(); ++cit)
       {
-        LRItemSet currentState = LRTable::computePaths(sourceState, *ait, i_grammar);
-        if(currentState.size() < 1)
+        size_t const stepBegin=m_unitSteps.size();
+        uint32_t destination=cit->second;
+        while(destination < rowCount && m_unitReductions[destination] != NO_PRODUCTION && m_unitSteps.size()-stepBegin < rowCount)
         {
-          continue;
-        }
+          uint32_t const unitIndex=m_unitReductions[destination];
+          m_unitSteps.push_back(UnitStep{destination, unitIndex});
 
-        bool stateFound=false;
-        for(std::vector<LRItemSet>::const_iterator vit=states.begin(); vit!=states.end(); ++vit)
-        {
-          if(*vit == currentState)
+          std::map<uint32_t, uint32_t>::const_iterator const nextCell=cells.find(symbolColumns[g.productionLeft(unitIndex)]);
+          if(nextCell == cells.end())
           {
-            stateFound = true;
+            m_unitSteps.resize(stepBegin);
             break;
           }
+          destination = nextCell->second;
         }
 
-        if(!stateFound)
+        if(m_unitSteps.size() > stepBegin)
         {
-          states.push_back(currentState);
-          itemAdded = true;
+          unitRows.back().push_back(std::make_pair(cit->first, uint32_t(m_unitPaths.size())));
+          m_unitPaths.push_back(UnitPath{destination, uint32_t(stepBegin), uint32_t(m_unitSteps.size())});
         }
       }
     }
+    m_pathRows[s] = row.first->second;
+  }
+  if(m_paths.size() < rowCount)
+  {
+    //States without paths share the empty row
+    std::pair<std::map<CombVector::Row, uint32_t>::iterator, bool> const row=rowIndices.insert(std::make_pair(CombVector::Row(), uint32_t(distinctRows.size())));
+    if(row.second)
+    {
+      distinctRows.push_back(CombVector::Row());
+      unitRows.emplace_back();
+    }
+    std::fill(m_pathRows.begin()+m_paths.size(), m_pathRows.end(), row.first->second);
   }
+  m_pathComb.pack(distinctRows, columnCount);
+  m_unitComb.pack(unitRows, columnCount);
+}
 
-#ifndef NDEBUG
-  printItemSetVector("States", states);
-#endif
+bool LRTable::dependsOn(LRItemSet const &i_itemSet, std::vector<bool> const &i_symbols, CompiledGrammar const &i_grammar)
+{
+  //Only the symbols after each dot feed the closure
+  for(size_t i=0; i<i_itemSet.size(); ++i)
+  {
+    LRItem const &item=i_itemSet.item(i);
+    SymbolId const * const right=i_grammar.productionRight(item.production());
+    for(size_t x=item.rightPosition(); x<i_grammar.productionLength(item.production()); ++x)
+    {
+      if(i_symbols[right[x]])
+      {
+        return true;
+      }
+    }
+  }
 
-  return states;
+  return false;
 }
 
-LRItemSet LRTable::closure(LRItemSet const &i_itemSet, Grammar const &i_grammar)
+LRTable::TransitionMap LRTable::computeTransitions(LRItemSet const &i_itemSet, CompiledGrammar const &i_grammar)
 {
-  if(!i_grammar.isContextFree())
+  //Items are sorted and advancing the dot keeps their order, so every
+  //kernel comes out sorted
+  TransitionMap transitions;
+
+  for(size_t i=0; i<i_itemSet.size(); ++i)
   {
-    throw std::logic_error("Tried to build first set for non-context-free grammar");
+    LRItem const &item=i_itemSet.item(i);
+    SymbolId const * const right=i_grammar.productionRight(item.production());
+    if(item.rightPosition() < i_grammar.productionLength(item.production()))
+    {
+      LRItemSet &kernelItems=transitions.emplace(right[item.rightPosition()], LRItemSet(i_itemSet.lookaheadWords())).first->second;
+      kernelItems.addLookaheads(kernelItems.add(item.advance()), i_itemSet.lookaheads(i));
+    }
   }
 
-  LRItemSet outputSet(i_itemSet);
+  return transitions;
+}
 
-  bool itemAdded = true;
-  while(itemAdded)
+LRState LRTable::insertState(LRItemSet &&i_kernelItems, bool &o_queue)
+{
+  //o_queue is set when the state has to be closed and filled: it is new, or
+  //it is an LALR state whose merged lookaheads grew
+  if(m_type == Type::LALR)
   {
-    itemAdded = false;
+    LRItemSet kernelCores;
+    for(size_t i=0; i<i_kernelItems.size(); ++i)
+    {
+      kernelCores.add(i_kernelItems.item(i));
+    }
 
-    /***** Go through all the items passed in *****/
-    for(LRItemSet::const_iterator lit=outputSet.begin(); lit!=outputSet.end(); ++lit)
+    std::pair<KernelMap::iterator, bool> const corePair=m_kernelStates.insert(KernelMap::value_type(std::move(kernelCores), LRState(m_kernels.size())));
+    LRState const state=corePair.first->second;
+    if(corePair.second)
     {
-      LRItem const &currentItem = (*lit);
-      SymbolList const &currentRight = currentItem.production().right();
-      if(currentItem.rightPosition() >= currentRight.count())
-      {
-        continue;
-      }
-      Symbol const &currentRightSymbol=currentRight[currentItem.rightPosition()];
+      m_mergedKernels.push_back(std::move(i_kernelItems));
+      m_kernels.push_back(&m_mergedKernels.back());
+      m_closureHashes.push_back(0);
+      o_queue = true;
+      return state;
+    }
 
-      /***** Compute up and coming symbols *****/
-      SymbolList currentRightEnding=currentRight.sublist(currentItem.rightPosition()+1);
-      currentRightEnding += currentItem.lookahead();
-      SymbolSet expectedSymbols = i_grammar.firstList(currentRightEnding);
+    //Both kernels are sorted by core, so their items line up
+    LRItemSet &mergedItems=m_mergedKernels[state];
+    o_queue = false;
+    for(size_t i=0; i<i_kernelItems.size(); ++i)
+    {
+      o_queue = mergedItems.addLookaheads(i, i_kernelItems.lookaheads(i)) || o_queue;
+    }
+    return state;
+  }
 
-      /***** Go through all the productions matching the next symbol *****/
-      for(size_t productionIndex=0; productionIndex<i_grammar.productionCount(); ++productionIndex)
-      {
-        Production const &p=i_grammar[productionIndex];
-        if(p.left()[0] != currentRightSymbol)
-        {
-          continue;
-        }
+  std::pair<KernelMap::iterator, bool> const kernelPair=m_kernelStates.insert(KernelMap::value_type(std::move(i_kernelItems), LRState(m_kernels.size())));
+  o_queue = kernelPair.second;
+  if(o_queue)
+  {
+    m_kernels.push_back(&kernelPair.first->first);
+    m_closureHashes.push_back(0);
+  }
 
-        for(SymbolSet::const_iterator esit=expectedSymbols.begin(); esit!=expectedSymbols.end(); ++esit)
-        {
-          LRItem finalItem(&p, 0, *esit);
-          
-          LRItemSet::const_iterator osit=outputSet.find(finalItem);
-          if(osit == outputSet.end())
-          {
-            outputSet.insert(std::move(finalItem));
-            itemAdded = true;
-          }
-        }
-      }
+  return kernelPair.first->second;
+}
+
+SymbolSet LRTable::expected(LRState const &i_currentState) const
+{
+  SymbolSet expectedSymbols;
+  if(i_currentState >= m_actions.size())
+  {
+    return expectedSymbols;
+  }
+
+  for(ActionRow::const_iterator ait=m_actions[i_currentState].begin(); ait!=m_actions[i_currentState].end(); ++ait)
+  {
+    if(!ait->second.isError())
+    {
+      expectedSymbols.insert(ait->first[0]);
     }
   }
 
-  return outputSet;
+  return expectedSymbols;
 }
 
-LRItemSet LRTable::computePaths(LRItemSet const &i_itemSet, Symbol const &i_symbol, Grammar const &i_grammar)
+void LRTable::fillState(LRState const &i_state, LRItemSet const &i_stateItems, CompiledGrammar const &i_grammar, LRStats * const io_stats, std::vector<LRState> &io_pendingStates)
 {
-  LRItemSet outputSet;
+  LRStats::Timer timer(io_stats, LRStats::Phase::TABLE);
 
-  for(LRItemSet::const_iterator isit=i_itemSet.begin(); isit!=i_itemSet.end(); ++isit)
+  /***** Start from an empty row *****/
+  if(i_state < m_actions.size())
   {
-    SymbolList const &right=isit->production().right();
-    if(isit->rightPosition() >= right.count())
+    m_actions[i_state].clear();
+  }
+  if(i_state < m_paths.size())
+  {
+    m_paths[i_state].clear();
+  }
+
+  /***** Build shifts and paths *****/
+  TransitionMap transitions=LRTable::computeTransitions(i_stateItems, i_grammar);
+  for(TransitionMap::iterator tit=transitions.begin(); tit!=transitions.end(); ++tit)
+  {
+    if(io_stats != nullptr)
     {
-      continue;
+      io_stats->add(LRStats::Counter::KERNEL_LOOKUPS);
     }
 
-    if(right[isit->rightPosition()] == i_symbol)
+    bool queued=false;
+    Symbol const &nextSymbol=i_grammar.symbol(tit->first);
+    LRState const nextState=this->insertState(std::move(tit->second), queued);
+    if(queued)
     {
-      outputSet.insert(LRItem(&isit->production(), isit->rightPosition()+1, isit->lookahead()));
+      io_pendingStates.push_back(nextState);
+    }
+
+    if(!i_grammar.isTerminal(tit->first))
+    {
+      this->insertPath(i_state, nextSymbol, nextState);
+    }
+    else
+    {
+      this->insertAction(i_state, nextSymbol, SHIFT(nextState));
     }
   }
 
-  return LRTable::closure(outputSet, i_grammar);
+  /***** Build reductions *****/
+  SymbolId const startSymbol=i_grammar.productionLeft(0);
+  for(size_t i=0; i<i_stateItems.size(); ++i)
+  {
+    LRItem const &item=i_stateItems.item(i);
+    if(item.rightPosition() < i_grammar.productionLength(item.production()))
+    {
+      continue;
+    }
+
+    SymbolId const left=i_grammar.productionLeft(item.production());
+    bool const isStart=(left == startSymbol);
+    uint64_t const *lookaheads=i_grammar.follow(left);
+    if(this->itemLookaheadWords() != 0)
+    {
+      lookaheads = i_stateItems.lookaheads(i);
+    }
+    else if(m_type == Type::LR0)
+    {
+      lookaheads = m_terminalBits.data();
+    }
+    for(size_t w=0; w<m_lookaheadWords; ++w)
+    {
+      for(uint64_t bits=lookaheads[w]; bits!=0; bits&=bits-1)
+      {
+        SymbolId const lookahead=SymbolId(w*64+__builtin_ctzll(bits));
+        if(isStart && lookahead == CompiledGrammar::END_ID)
+        {
+          this->insertAction(i_state, END(), ACCEPT());
+        }
+        else if(this->resolvePrecedence(i_state, lookahead, item.production(), i_grammar, io_stats))
+        {
+          this->insertAction(i_state, i_grammar.symbol(lookahead), REDUCE(item.production()));
+        }
+      }
+    }
+  }
 }
 
 
@@ -413,25 +834,330 @@ void LRTable::insertPath(LRState const &i_state, SymbolList const &i_symbolList,
 
 LRState LRTable::path(LRState const &i_currentState, SymbolList const &i_symbolList) const
 {
-  std::pair<PathRow::const_iterator, PathRow::const_iterator> pathPair = m_paths.at(i_currentState).equal_range(i_symbolList);
+  if(i_currentState >= m_paths.size())
+  {
+    return LRSTATE_INVALID;
+  }
 
-  /***** Nothing *****/
+  std::pair<PathRow::const_iterator, PathRow::const_iterator> pathPair = m_paths[i_currentState].equal_range(i_symbolList);
+
+  /***** Nothing; a state has one transition per symbol, so never more than one *****/
   if(pathPair.first == pathPair.second)
   {
-    throw std::out_of_range(i_symbolList.toString());
+    return LRSTATE_INVALID;
   }
 
-  /***** More than one *****/
-  PathRow::const_iterator pathNext = ++pathPair.first;
-  if(pathNext != pathPair.second)
+  return pathPair.first->second;
+}
+
+size_t LRTable::compressedSizeBytes() const
+{
+  //Only what parsing reads; the terminal class map is estimated like the rows in sizeBytes()
+  size_t sizeBytes=m_actionComb.sizeBytes() + m_pathComb.sizeBytes() + m_unitComb.sizeBytes();
+  sizeBytes += m_unitReductions.capacity()*sizeof(uint32_t) + m_unitPaths.capacity()*sizeof(UnitPath) + m_unitSteps.capacity()*sizeof(UnitStep);
+  sizeBytes += m_actionPool.capacity()*sizeof(LRAction);
+  sizeBytes += (m_actionDefaults.capacity()+m_actionRows.capacity()+m_pathRows.capacity())*sizeof(uint32_t);
+  sizeBytes += m_terminals.bucket_count()*sizeof(void *);
+  for(std::unordered_map<Symbol, Terminal>::const_iterator tit=m_terminals.begin(); tit!=m_terminals.end(); ++tit)
+  {
+    sizeBytes += sizeof(std::pair<Symbol, Terminal>) + sizeof(void *) + tit->first.sizeBytes();
+  }
+  sizeBytes += (m_pathColumns.capacity()+m_productionLengths.capacity())*sizeof(uint32_t);
+  sizeBytes += m_productionLefts.capacity()*sizeof(Symbol);
+  for(Symbol const &left : m_productionLefts)
   {
-    throw std::range_error("Reduce/reduce conflict");
+    sizeBytes += left.sizeBytes();
   }
 
-  return pathPair.first->second;
+  return sizeBytes;
+}
+
+size_t LRTable::coreCount() const
+{
+  size_t coreCount=0;
+  for(LRItemSet const * const kernelItems : m_kernels)
+  {
+    coreCount += kernelItems->size();
+  }
+
+  return coreCount;
+}
+
+size_t LRTable::itemCount() const
+{
+  //Canonical kernel items, one per core and lookahead; LR(0) items are the cores
+  if(this->itemLookaheadWords() == 0)
+  {
+    return this->coreCount();
+  }
+
+  size_t itemCount=0;
+  for(LRItemSet const * const kernelItems : m_kernels)
+  {
+    itemCount += kernelItems->lookaheadCount();
+  }
+
+  return itemCount;
+}
+
+void LRTable::resizeLookaheads(size_t const i_lookaheadWords)
+{
+  //Kernels are hashed with their lookaheads, so the map is rebuilt
+  KernelMap kernelStates;
+  for(size_t i=0; i<m_kernels.size(); ++i)
+  {
+    LRItemSet kernelItems(*m_kernels[i]);
+    kernelItems.resizeLookaheads(i_lookaheadWords);
+    m_kernels[i] = &kernelStates.insert(KernelMap::value_type(std::move(kernelItems), LRState(i))).first->first;
+  }
+
+  m_kernelStates = std::move(kernelStates);
+  m_lookaheadWords = i_lookaheadWords;
+}
+
+size_t LRTable::itemLookaheadWords() const
+{
+  //Only LR(1) and LALR(1) items carry their own lookaheads
+  return (m_type == Type::LR || m_type == Type::LALR) ? m_lookaheadWords : 0;
+}
+
+bool LRTable::resolvePrecedence(LRState const &i_state, SymbolId const i_lookahead, size_t const i_productionIndex, CompiledGrammar const &i_grammar, LRStats * const io_stats)
+{
+  //Settles a shift/reduce conflict as yacc does, by comparing the precedence
+  //of the production with the lookahead's, then by the lookahead's
+  //associativity; returns whether the reduction should still be added
+  size_t const tokenPrecedence=i_grammar.precedence(i_lookahead);
+  if(tokenPrecedence == 0 || i_state >= m_actions.size())
+  {
+    return true;
+  }
+  size_t const productionPrecedence=i_grammar.productionPrecedence(i_productionIndex);
+  if(productionPrecedence == 0)
+  {
+    return true;
+  }
+
+  SymbolList const lookaheadList(i_grammar.symbol(i_lookahead));
+  ActionRow &row=m_actions[i_state];
+  std::pair<ActionRow::iterator, ActionRow::iterator> const actionPair=row.equal_range(lookaheadList);
+  ActionRow::iterator const shift=std::find_if(actionPair.first, actionPair.second, [](ActionRow::value_type const &i_entry){return i_entry.second.isShift();});
+  if(shift == actionPair.second)
+  {
+    return true;
+  }
+
+  if(io_stats != nullptr)
+  {
+    io_stats->add(LRStats::Counter::CONFLICTS_RESOLVED);
+  }
+
+  Grammar::Associativity const associativity=i_grammar.associativity(i_lookahead);
+  if(productionPrecedence < tokenPrecedence || (productionPrecedence == tokenPrecedence && associativity == Grammar::Associativity::RIGHT))
+  {
+    return false;
+  }
+
+  row.erase(shift);
+  if(productionPrecedence == tokenPrecedence && associativity == Grammar::Associativity::NONASSOC)
+  {
+    //Kept as an explicit entry so no default reduction covers it
+    row.insert(std::pair<SymbolList, LRAction>(lookaheadList, ERROR()));
+    return false;
+  }
+
+  return true;
+}
+
+size_t LRTable::sizeBytes() const
+{
+  //Estimate of the heap used by the ACTION and GOTO rows: bucket arrays,
+  //one node per entry, and the symbols owned by each key
+  size_t sizeBytes=0;
+  for(ActionRow const &row : m_actions)
+  {
+    sizeBytes += sizeof(ActionRow) + row.bucket_count()*sizeof(void *);
+    for(ActionRow::const_iterator ait=row.begin(); ait!=row.end(); ++ait)
+    {
+      sizeBytes += sizeof(ActionRow::value_type) + 2*sizeof(void *);
+      for(size_t x=0; x<ait->first.count(); ++x)
+      {
+        sizeBytes += sizeof(Symbol) + ait->first[x].sizeBytes();
+      }
+    }
+  }
+
+  for(PathRow const &row : m_paths)
+  {
+    sizeBytes += sizeof(PathRow) + row.bucket_count()*sizeof(void *);
+    for(PathRow::const_iterator pit=row.begin(); pit!=row.end(); ++pit)
+    {
+      sizeBytes += sizeof(PathRow::value_type) + 2*sizeof(void *);
+      for(size_t x=0; x<pit->first.count(); ++x)
+      {
+        sizeBytes += sizeof(Symbol) + pit->first[x].sizeBytes();
+      }
+    }
+  }
+
+  return sizeBytes;
+}
+
+size_t LRTable::stateCount() const
+{
+  return m_kernels.size();
+}
+
+LRTable::Terminal LRTable::terminal(Symbol const &i_token) const
+{
+  std::unordered_map<Symbol, Terminal>::const_iterator tit=m_terminals.find(i_token);
+  if(tit == m_terminals.end())
+  {
+    return Terminal{SYMBOLID_INVALID, NO_CLASS};
+  }
+
+  return tit->second;
+}
+
+void LRTable::update(Grammar const &i_grammar, LRStats * const io_stats)
+{
+  if(m_type != Type::LR)
+  {
+    throw std::logic_error("Only LR tables support incremental updates");
+  }
+  if(m_grammar == nullptr)
+  {
+    throw std::logic_error("Tables built from a CompiledGrammar cannot be updated");
+  }
+  if(!i_grammar.isContextFree())
+  {
+    throw std::logic_error("Grammar is not context-free");
+  }
+
+  //Nullable, FIRST and FOLLOW are recomputed in full; only the automaton is
+  //updated in place
+  std::shared_ptr<CompiledGrammar const> const compiledGrammar(new CompiledGrammar(i_grammar, CompiledGrammar::Numbering::GRAMMAR, io_stats));
+  CompiledGrammar const &g=*compiledGrammar;
+  std::shared_ptr<CompiledGrammar const> const previousGrammar=m_grammar;
+  CompiledGrammar const &oldGrammar=*previousGrammar;
+
+  /***** Anything but appended productions is rebuilt from scratch *****/
+  if(!extendsGrammar(oldGrammar, g))
+  {
+    m_actions.clear();
+    m_paths.clear();
+    m_kernelStates.clear();
+    m_mergedKernels.clear();
+    m_kernels.clear();
+    m_closureHashes.clear();
+    m_terminalBits.clear();
+    m_grammar = compiledGrammar;
+    this->build(g, io_stats);
+    return;
+  }
+  if(g.productionCount() == oldGrammar.productionCount())
+  {
+    return;
+  }
+  LRItem::checkLimits(g);
+  LRAction::checkLimits(g);
+
+  /***** Collect symbols whose productions, FIRST set or nullability changed *****/
+  //Appending productions only appends symbols, so old IDs still mean the same symbols
+  std::vector<bool> changedSymbols(g.symbolCount(), false);
+  for(size_t i=oldGrammar.productionCount(); i<g.productionCount(); ++i)
+  {
+    changedSymbols[g.productionLeft(i)] = true;
+  }
+  for(SymbolId i=0; i<g.symbolCount(); ++i)
+  {
+    if(i >= oldGrammar.symbolCount() || g.nullable(i) != oldGrammar.nullable(i))
+    {
+      changedSymbols[i] = true;
+      continue;
+    }
+
+    for(size_t w=0; w<g.setWords(); ++w)
+    {
+      uint64_t const oldWord=(w < oldGrammar.setWords()) ? oldGrammar.first(i)[w] : 0;
+      if(g.first(i)[w] != oldWord)
+      {
+        changedSymbols[i] = true;
+        break;
+      }
+    }
+  }
+
+  /***** New symbols may need wider lookahead sets *****/
+  if(g.setWords() != m_lookaheadWords)
+  {
+    this->resizeLookaheads(g.setWords());
+  }
+
+  /***** A closure can change if the kernel reaches a changed symbol through predicted productions *****/
+  bool symbolAdded=true;
+  while(symbolAdded)
+  {
+    symbolAdded = false;
+    for(size_t i=0; i<g.productionCount(); ++i)
+    {
+      SymbolId const * const right=g.productionRight(i);
+      if(!changedSymbols[g.productionLeft(i)] && std::any_of(right, right+g.productionLength(i), [&changedSymbols](SymbolId const i_symbolId){return changedSymbols[i_symbolId];}))
+      {
+        changedSymbols[g.productionLeft(i)] = true;
+        symbolAdded = true;
+      }
+    }
+  }
+  m_grammar = compiledGrammar;
+
+  /***** Reclose the states that may see a change, refilling those whose closure did change *****/
+  LRStats::Timer timer(io_stats, LRStats::Phase::STATES);
+  std::vector<LRState> changedStates;
+  std::vector<std::pair<LRState, LRItemSet>> matchedStates;
+  for(size_t i=0; i<m_kernels.size(); ++i)
+  {
+    if(!LRTable::dependsOn(*m_kernels[i], changedSymbols, g))
+    {
+      continue;
+    }
+
+    if(io_stats != nullptr)
+    {
+      io_stats->add(LRStats::Counter::STATES_RECLOSED);
+    }
+    //A different hash settles it; an equal one still needs the exact comparison
+    LRItemSet closureItems=this->closure(*m_kernels[i], g, io_stats);
+    if(closureItems.hash() != m_closureHashes[i])
+    {
+      changedStates.push_back(LRState(i));
+    }
+    else
+    {
+      matchedStates.push_back(std::make_pair(LRState(i), std::move(closureItems)));
+    }
+  }
+
+  //Only the hashes of old closures are kept, so those kernels are closed
+  //again under the old grammar; cached shapes belong to one grammar
+  m_closureCache.clear();
+  for(std::pair<LRState, LRItemSet> const &matchedState : matchedStates)
+  {
+    if(this->closure(*m_kernels[matchedState.first], oldGrammar, io_stats) != matchedState.second)
+    {
+      changedStates.push_back(matchedState.first);
+    }
+  }
+  m_closureCache.clear();
+  std::sort(changedStates.begin(), changedStates.end());
+
+  //Unchanged states keep their transitions; changed states may reach new kernels,
+  //whose old counterparts stay in the table as unreachable rows
+  this->buildLRItems(changedStates, g, io_stats);
+  m_closureCache.clear();
+  this->compress(g);
 }
 
-std::string LRTable::toString() const
+std::string LRTable::toString(CompiledGrammar const &i_grammar) const
 {
   std::string outputString;
   for(size_t stateIndex=0; stateIndex<std::max(m_actions.size(), m_paths.size()); ++stateIndex)
@@ -441,7 +1167,7 @@ std::string LRTable::toString() const
     {
       for(ActionRow::const_iterator ait=m_actions[stateIndex].begin(); ait!=m_actions[stateIndex].end(); ++ait)
       {
-        outputString += "\t (" + ait->first.toString() + ") -> " + ait->second.toString() + "\n";
+        outputString += "\t (" + ait->first.toString() + ") -> " + ait->second.toString(i_grammar) + "\n";
       }
     }
 
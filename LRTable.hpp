@@ -1,16 +1,27 @@
 #ifndef _LRTABLE_HPP_
 #define _LRTABLE_HPP_
 
+#include "CombVector.hpp"
+#include "CompiledGrammar.hpp"
 #include "Grammar.hpp"
+#include "LRClosureCache.hpp"
 #include "LRAction.hpp"
 #include "LRItem.hpp"
 #include "LRState.hpp"
+#include "LRStats.hpp"
 #include "Symbol.hpp"
 
+#include <deque>
+#include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
 /********************----- CLASS: LRTable -----********************/
+//Built from a CompiledGrammar, which it reads only while building. A table
+//built from a Grammar compiles it with the grammar's own symbol IDs and
+//keeps that copy, so update() can extend it as productions are appended;
+//any other change to the grammar makes update() rebuild the table
 class LRTable
 {
 public:
@@ -19,35 +30,198 @@ public:
     GLR,
     LALR,
     LR,
+    LR0,
+    SLR,
   };
 
-  LRTable(LRTable::Type const i_type, Grammar const &i_grammar);
+  //Terminals that act alike in every state share a class, see compress()
+  typedef uint32_t TerminalClass;
+  static TerminalClass const NO_CLASS=UINT32_MAX;
+  static uint32_t const NO_PRODUCTION=UINT32_MAX;
+
+  //What a token is parsed as: its symbol ID in the grammar, for traces, and
+  //its class, NO_CLASS for tokens no state acts on by name
+  struct Terminal
+  {
+    SymbolId id;
+    TerminalClass terminalClass;
+  };
+
+  //A chain of unit reductions skipped by unitPath(): each step is a state
+  //whose only action is a reduction A ::= B, and that production
+  struct UnitStep
+  {
+    LRState state;
+    uint32_t productionIndex;
+  };
+  struct UnitPath
+  {
+    LRState state;
+    uint32_t stepBegin;
+    uint32_t stepEnd;
+  };
+
+  LRTable(LRTable::Type const i_type, Grammar const &i_grammar, LRStats * const io_stats=nullptr);
+  LRTable(LRTable::Type const i_type, CompiledGrammar const &i_grammar, LRStats * const io_stats=nullptr);
+  //A copy can be updated while parses go on with the original
+  LRTable(LRTable const &i_table);
 
   LRAction action(LRState const &i_currentState, SymbolList const &i_token) const;
+  SymbolSet expected(LRState const &i_currentState) const;
   LRState path(LRState const &i_currentState, SymbolList const &i_symbol) const;
 
-  std::string toString() const;
+  /***** Compressed lookups used while parsing *****/
+  LRAction const &action(LRState const i_currentState, TerminalClass const i_class) const;
+  LRState path(LRState const i_currentState, uint32_t const i_reducedIndex) const;
+  Symbol const &productionLeft(uint32_t const i_productionIndex) const;
+  size_t productionLength(uint32_t const i_productionIndex) const;
+  Terminal terminal(Symbol const &i_token) const;
+  UnitPath const *unitPath(LRState const i_currentState, uint32_t const i_reducedIndex) const;
+  uint32_t unitReduction(LRState const i_state) const;
+  UnitStep const &unitStep(size_t const i_stepIndex) const;
+
+  void update(Grammar const &i_grammar, LRStats * const io_stats=nullptr);
+
+  size_t compressedSizeBytes() const;
+  size_t coreCount() const;
+  size_t itemCount() const;
+  size_t sizeBytes() const;
+  size_t stateCount() const;
+  std::string toString(CompiledGrammar const &i_grammar) const;
 protected:
-  static LRItemSetVector buildLALRItems(Grammar const &i_grammar);
-  static LRItemSetVector buildLRItems(Grammar const &i_grammar);
-  static LRItemSet closure(LRItemSet const &i_item, Grammar const &i_grammar);
-  static LRItemSet computeKernelItems(LRItemSet const &i_kernelItems, LRItemSet const &i_nonkernelItems, Grammar const &i_grammar);
-  static LRItemSet computeNonkernelItems(LRItemSet const &i_kernelItems, Grammar const &i_grammar);
-  static LRItemSet computePaths(LRItemSet const &i_itemSet, Symbol const &i_symbol, Grammar const &i_grammar);
+  typedef std::map<SymbolId, LRItemSet> TransitionMap;
 
+  void build(CompiledGrammar const &i_grammar, LRStats * const io_stats);
+  void buildLRItems(std::vector<LRState> &io_pendingStates, CompiledGrammar const &i_grammar, LRStats * const io_stats);
+  LRItemSet closure(LRItemSet const &i_kernelItems, CompiledGrammar const &i_grammar, LRStats * const io_stats) const;
+  LRClosureCache::Entry closureShape(LRItemSet const &i_kernelCores, CompiledGrammar const &i_grammar, size_t &io_iterationCount) const;
+  void compress(CompiledGrammar const &i_grammar);
+  static TransitionMap computeTransitions(LRItemSet const &i_itemSet, CompiledGrammar const &i_grammar);
+  static bool dependsOn(LRItemSet const &i_itemSet, std::vector<bool> const &i_symbols, CompiledGrammar const &i_grammar);
+  size_t itemLookaheadWords() const;
+
+  void fillState(LRState const &i_state, LRItemSet const &i_stateItems, CompiledGrammar const &i_grammar, LRStats * const io_stats, std::vector<LRState> &io_pendingStates);
   void insertAction(LRState const &i_state, SymbolList const &i_symbolList, LRAction const &i_action);
   void insertPath(LRState const &i_state, SymbolList const &i_symbolList, LRState const &i_destinationState);
+  LRState insertState(LRItemSet &&i_kernelItems, bool &o_queue);
+  bool resolvePrecedence(LRState const &i_state, SymbolId const i_lookahead, size_t const i_productionIndex, CompiledGrammar const &i_grammar, LRStats * const io_stats);
+  void resizeLookaheads(size_t const i_lookaheadWords);
 
 private:
+  LRTable &operator =(LRTable const &)=delete;
+
   typedef std::unordered_multimap<SymbolList, LRAction> ActionRow;
   typedef std::unordered_multimap<SymbolList, LRState> PathRow;
   typedef std::vector<ActionRow> ActionTable;
   typedef std::vector<PathRow> PathTable;
+  typedef std::unordered_map<LRItemSet, LRState> KernelMap;
+  typedef std::vector<LRItemSet const *> KernelVector;
 
   ActionTable m_actions;
   PathTable m_paths;
   LRTable::Type m_type;
+
+  //Closure shapes are only kept while building or updating
+  static size_t const CLOSURE_CACHE_CAPACITY=4096;
+  mutable LRClosureCache m_closureCache;
+
+  /***** Automaton kept for incremental updates; LALR maps cores to states and keeps the merged kernels apart *****/
+  KernelMap m_kernelStates;
+  std::deque<LRItemSet> m_mergedKernels;
+  KernelVector m_kernels;
+  std::vector<size_t> m_closureHashes;
+  std::vector<uint64_t> m_terminalBits;
+  size_t m_lookaheadWords;
+
+  //The grammar the table was last built or updated from, when given a Grammar
+  std::shared_ptr<CompiledGrammar const> m_grammar;
+
+  /***** Compressed tables, rebuilt after every build or update *****/
+  static uint32_t const ACTION_ERROR=0;
+
+  std::unordered_map<Symbol, Terminal> m_terminals;
+  std::vector<LRAction> m_actionPool;
+  std::vector<uint32_t> m_actionDefaults;
+  std::vector<uint32_t> m_actionRows;
+  CombVector m_actionComb;
+  std::vector<uint32_t> m_pathColumns;
+  std::vector<Symbol> m_productionLefts;
+  std::vector<uint32_t> m_productionLengths;
+  std::vector<uint32_t> m_pathRows;
+  CombVector m_pathComb;
+
+  /***** Unit reductions bypassed through paths, see unitPath() *****/
+  std::vector<uint32_t> m_unitReductions;
+  std::vector<UnitPath> m_unitPaths;
+  std::vector<UnitStep> m_unitSteps;
+  CombVector m_unitComb;
 };
 /**************************************************/
 
+/********************----- Inline Functions -----********************/
+//Called for every parser step; a state without an entry for the class takes
+//its default reduction, or errors. compress() leaves no conflicts to check for
+inline LRAction const &LRTable::action(LRState const i_currentState, TerminalClass const i_class) const
+{
+  uint32_t actionIndex=(i_class != NO_CLASS) ? m_actionComb.find(m_actionRows[i_currentState], i_class) : CombVector::NO_VALUE;
+  if(actionIndex == CombVector::NO_VALUE)
+  {
+    actionIndex = m_actionDefaults[i_currentState];
+  }
+
+  return m_actionPool[actionIndex];
+}
+
+inline LRState LRTable::path(LRState const i_currentState, uint32_t const i_reducedIndex) const
+{
+  uint32_t const destination=m_pathComb.find(m_pathRows[i_currentState], m_pathColumns[i_reducedIndex]);
+  if(destination == CombVector::NO_VALUE)
+  {
+    return LRSTATE_INVALID;
+  }
+
+  return destination;
+}
+
+//Where a path lands once every unit reduction it leads into has been
+//applied, or nullptr when it leads into none
+inline LRTable::UnitPath const *LRTable::unitPath(LRState const i_currentState, uint32_t const i_reducedIndex) const
+{
+  uint32_t const unitIndex=m_unitComb.find(m_pathRows[i_currentState], m_pathColumns[i_reducedIndex]);
+  if(unitIndex == CombVector::NO_VALUE)
+  {
+    return nullptr;
+  }
+
+  return &m_unitPaths[unitIndex];
+}
+
+//The table keeps its own copy of what reductions need, so it never points
+//into the grammar it was built from
+inline Symbol const &LRTable::productionLeft(uint32_t const i_productionIndex) const
+{
+  return m_productionLefts[i_productionIndex];
+}
+
+inline size_t LRTable::productionLength(uint32_t const i_productionIndex) const
+{
+  return m_productionLengths[i_productionIndex];
+}
+
+inline uint32_t LRTable::unitReduction(LRState const i_state) const
+{
+  if(i_state >= m_unitReductions.size())
+  {
+    return NO_PRODUCTION;
+  }
+
+  return m_unitReductions[i_state];
+}
+
+inline LRTable::UnitStep const &LRTable::unitStep(size_t const i_stepIndex) const
+{
+  return m_unitSteps[i_stepIndex];
+}
+/**************************************************/
+
 #endif /* _LRTABLE_HPP_ */
@@ -0,0 +1,220 @@
+#include "LRTrace.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+/********************----- Helpers -----********************/
+//File layout, all integers little-endian:
+//  "LRT1"
+//  u32 token count,      then per symbol ID:  u32 length + name bytes
+//  u32 production count, then per production: u32 length + text bytes
+//  u64 steps recorded in total
+//  u32 event count,      then per event (oldest first): u32 state, u32 token, u32 action
+//An action packs its type into the top two bits and the shifted state or
+//reduced production index into the rest.
+namespace
+{
+  char const TRACE_MAGIC[4]={'L', 'R', 'T', '1'};
+  unsigned const ACTION_TYPE_SHIFT=30;
+  uint32_t const ACTION_OPERAND_MASK=(uint32_t(1) << ACTION_TYPE_SHIFT)-1;
+
+  void writeInteger(std::ostream &o_output, uint64_t const i_value, size_t const i_sizeBytes)
+  {
+    for(size_t i=0; i<i_sizeBytes; ++i)
+    {
+      o_output.put(static_cast<char>((i_value >> (8*i)) & 0xFF));
+    }
+  }
+
+  uint64_t readInteger(std::istream &i_input, size_t const i_sizeBytes)
+  {
+    uint64_t value=0;
+    for(size_t i=0; i<i_sizeBytes; ++i)
+    {
+      int const c=i_input.get();
+      if(c == std::char_traits<char>::eof())
+      {
+        throw std::runtime_error("Truncated trace");
+      }
+      value |= uint64_t(static_cast<unsigned char>(c)) << (8*i);
+    }
+
+    return value;
+  }
+
+  void writeStrings(std::ostream &o_output, std::vector<std::string> const &i_strings)
+  {
+    writeInteger(o_output, i_strings.size(), 4);
+    for(std::string const &s : i_strings)
+    {
+      writeInteger(o_output, s.size(), 4);
+      o_output.write(s.data(), s.size());
+    }
+  }
+
+  std::vector<std::string> readStrings(std::istream &i_input)
+  {
+    std::vector<std::string> strings(readInteger(i_input, 4));
+    for(std::string &s : strings)
+    {
+      s.resize(readInteger(i_input, 4));
+      if(!i_input.read(&s[0], s.size()))
+      {
+        throw std::runtime_error("Truncated trace");
+      }
+    }
+
+    return strings;
+  }
+
+  std::string lookupName(std::vector<std::string> const &i_names, uint32_t const i_id)
+  {
+    if(i_id >= i_names.size())
+    {
+      return "?";
+    }
+
+    return i_names[i_id];
+  }
+}
+/**************************************************/
+
+/********************----- CLASS: LRTrace -----********************/
+LRTrace::LRTrace(Grammar const &i_grammar, size_t const i_capacity)
+:m_events(std::max<size_t>(1, i_capacity)), m_next(0)
+{
+  /***** Tokens are named by symbol ID; nonterminals are never tokens and stay unnamed *****/
+  for(SymbolId i=0; i<i_grammar.symbolCount(); ++i)
+  {
+    m_tokenNames.push_back(i_grammar.symbol(i).isNonterminal() ? std::string() : i_grammar.symbol(i).toString());
+  }
+
+  for(size_t i=0; i<i_grammar.productionCount(); ++i)
+  {
+    m_productionNames.push_back(i_grammar[i].toString());
+  }
+}
+
+LRTrace::LRTrace(CompiledGrammar const &i_grammar, size_t const i_capacity)
+:m_events(std::max<size_t>(1, i_capacity)), m_next(0)
+{
+  for(SymbolId i=0; i<i_grammar.symbolCount(); ++i)
+  {
+    m_tokenNames.push_back(i_grammar.isTerminal(i) ? i_grammar.symbol(i).toString() : std::string());
+  }
+
+  for(size_t i=0; i<i_grammar.productionCount(); ++i)
+  {
+    m_productionNames.push_back(i_grammar.productionString(i));
+  }
+}
+
+size_t LRTrace::capacity() const
+{
+  return m_events.size();
+}
+
+void LRTrace::clear()
+{
+  m_next = 0;
+}
+
+void LRTrace::decode(std::istream &i_input, std::ostream &o_output)
+{
+  char magic[sizeof(TRACE_MAGIC)];
+  if(!i_input.read(magic, sizeof(magic)) || !std::equal(magic, magic+sizeof(magic), TRACE_MAGIC))
+  {
+    throw std::runtime_error("Not a parser trace");
+  }
+
+  std::vector<std::string> const tokenNames=readStrings(i_input);
+  std::vector<std::string> const productionNames=readStrings(i_input);
+  uint64_t const recordCount=readInteger(i_input, 8);
+  uint64_t const eventCount=readInteger(i_input, 4);
+
+  /***** One line per step, numbered from the start of the parse *****/
+  for(uint64_t i=0; i<eventCount; ++i)
+  {
+    uint32_t const state=readInteger(i_input, 4);
+    uint32_t const token=readInteger(i_input, 4);
+    uint32_t const action=readInteger(i_input, 4);
+    uint32_t const operand=action & ACTION_OPERAND_MASK;
+
+    std::string actionString;
+    switch(static_cast<LRAction::Type>(action >> ACTION_TYPE_SHIFT))
+    {
+      case LRAction::Type::ACCEPT:
+        actionString = "ACCEPT()";
+        break;
+      case LRAction::Type::ERROR:
+        actionString = "ERROR()";
+        break;
+      case LRAction::Type::REDUCE:
+        actionString = "REDUCE(" + lookupName(productionNames, operand) + ")";
+        break;
+      case LRAction::Type::SHIFT:
+        actionString = "SHIFT(" + std::to_string(operand) + ")";
+        break;
+    }
+
+    o_output << (recordCount-eventCount+i) << ": (" << state << " + " << lookupName(tokenNames, token) << ") --> " << actionString << "\n";
+  }
+}
+
+void LRTrace::record(LRState const i_state, SymbolId const i_tokenId, LRAction const &i_action)
+{
+  Event &event=m_events[m_next % m_events.size()];
+  ++m_next;
+
+  event.state = uint32_t(i_state);
+  event.token = (i_tokenId < m_tokenNames.size()) ? i_tokenId : UNKNOWN_TOKEN;
+  event.action = uint32_t(enum_value(i_action.type())) << ACTION_TYPE_SHIFT;
+  if(i_action.isShift())
+  {
+    event.action |= uint32_t(i_action.state()) & ACTION_OPERAND_MASK;
+  }
+  else if(i_action.isReduce())
+  {
+    event.action |= i_action.productionIndex() & ACTION_OPERAND_MASK;
+  }
+}
+
+size_t LRTrace::recordCount() const
+{
+  return m_next;
+}
+
+void LRTrace::save(std::string const &i_filepath) const
+{
+  std::ofstream output(i_filepath.c_str(), std::ios::binary|std::ios::trunc);
+  this->write(output);
+  if(!output)
+  {
+    throw std::runtime_error("Unable to write trace to " + i_filepath);
+  }
+}
+
+size_t LRTrace::size() const
+{
+  return std::min(m_next, m_events.size());
+}
+
+void LRTrace::write(std::ostream &o_output) const
+{
+  o_output.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  writeStrings(o_output, m_tokenNames);
+  writeStrings(o_output, m_productionNames);
+  writeInteger(o_output, m_next, 8);
+  writeInteger(o_output, this->size(), 4);
+
+  /***** Oldest event first *****/
+  for(size_t i=m_next-this->size(); i<m_next; ++i)
+  {
+    Event const &event=m_events[i % m_events.size()];
+    writeInteger(o_output, event.state, 4);
+    writeInteger(o_output, event.token, 4);
+    writeInteger(o_output, event.action, 4);
+  }
+}
+/**************************************************/
@@ -0,0 +1,64 @@
+#ifndef _LRTRACE_HPP_
+#define _LRTRACE_HPP_
+
+#include "CompiledGrammar.hpp"
+#include "Grammar.hpp"
+#include "LRAction.hpp"
+#include "LRState.hpp"
+#include "Symbol.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/********************----- CLASS: LRTrace -----********************/
+//Fixed-size ring buffer of parser steps. Attach one to a ParseSession to
+//start recording and detach it to stop; only the newest steps are kept.
+//Tokens are recorded by their symbol ID, as the parser has it from
+//LRTable::terminal(); build the trace from the grammar the table was built
+//from, so the IDs name the right tokens. save() writes the steps together with the
+//symbol and production names they refer to, so a trace can be decoded
+//without the grammar.
+class LRTrace
+{
+public:
+  struct Event
+  {
+    uint32_t state;
+    uint32_t token;
+    uint32_t action;
+  };
+
+  static uint32_t const UNKNOWN_TOKEN=UINT32_MAX;
+
+  LRTrace(Grammar const &i_grammar, size_t const i_capacity=65536);
+  LRTrace(CompiledGrammar const &i_grammar, size_t const i_capacity=65536);
+  virtual ~LRTrace(){}
+
+  void clear();
+  size_t capacity() const;
+  size_t recordCount() const;
+  size_t size() const;
+
+  void record(LRState const i_state, SymbolId const i_tokenId, LRAction const &i_action);
+  void save(std::string const &i_filepath) const;
+  void write(std::ostream &o_output) const;
+
+  static void decode(std::istream &i_input, std::ostream &o_output);
+
+private:
+  LRTrace(LRTrace const &)=delete;
+  LRTrace &operator =(LRTrace const &)=delete;
+
+  /***** Dictionaries written alongside the events; tokens are indexed by symbol ID *****/
+  std::vector<std::string> m_tokenNames;
+  std::vector<std::string> m_productionNames;
+
+  std::vector<Event> m_events;
+  size_t m_next;
+};
+/**************************************************/
+
+#endif /* _LRTRACE_HPP_ */
@@ -1,83 +1,351 @@
 #include "LexText.hpp"
 
-/********************----- CLASS: LexText -----********************/
-LexText::LexText(std::string const &i_filepath)
-:m_input(i_filepath.c_str())
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/********************----- Helper Functions -----********************/
+//Token boundaries are found a vector at a time where the CPU allows:
+//whitespace is ' ' or '\t' to '\r', and runs are ASCII letters and digits,
+//as isspace()/isalnum() classify them in the C locale
+typedef char const *(*Scanner)(char const * const i_begin, char const * const i_end);
+
+struct Scanners
+{
+  Scanner skipSpace;
+  Scanner skipAlnum;
+};
+
+static bool isAlnumByte(char const i_c)
 {
+  unsigned char const c=static_cast<unsigned char>(i_c);
+  return (unsigned(c-'0') <= 9u) || (unsigned((c|0x20)-'a') <= 25u);
 }
 
-LexText::~LexText()
+static bool isSpaceByte(char const i_c)
 {
+  unsigned char const c=static_cast<unsigned char>(i_c);
+  return (c == ' ') || (unsigned(c-'\t') <= 4u);
 }
 
-Symbol LexText::pop()
+static char const *skipAlnumScalar(char const * const i_begin, char const * const i_end)
 {
-  char c;
-  std::string s;
-  bool cAlnum = false;
-  bool cSpace = false;
+  char const *c=i_begin;
+  while(c != i_end && isAlnumByte(*c))
+  {
+    ++c;
+  }
+  return c;
+}
 
-  /***** Skip whitespace *****/
-  while(!m_input.eof())
+static char const *skipSpaceScalar(char const * const i_begin, char const * const i_end)
+{
+  char const *c=i_begin;
+  while(c != i_end && isSpaceByte(*c))
   {
-    c = m_input.peek();
-    if(isspace(c))
+    ++c;
+  }
+  return c;
+}
+
+#if defined(__SSE2__)
+//Unsigned "x-low <= span" for every byte: min(x-low, span) == x-low
+static __m128i inRange16(__m128i const i_bytes, char const i_low, char const i_span)
+{
+  __m128i const offset=_mm_sub_epi8(i_bytes, _mm_set1_epi8(i_low));
+  return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(i_span)), offset);
+}
+
+static char const *skipAlnumSSE2(char const * const i_begin, char const * const i_end)
+{
+  char const *c=i_begin;
+  for(; i_end-c >= 16; c+=16)
+  {
+    __m128i const bytes=_mm_loadu_si128(reinterpret_cast<__m128i const *>(c));
+    __m128i const alnum=_mm_or_si128(inRange16(bytes, '0', 9), inRange16(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 25));
+    unsigned const stops=~unsigned(_mm_movemask_epi8(alnum)) & 0xFFFFu;
+    if(stops != 0)
     {
-      m_input.get();
+      return c+__builtin_ctz(stops);
     }
-    else
+  }
+  return skipAlnumScalar(c, i_end);
+}
+
+static char const *skipSpaceSSE2(char const * const i_begin, char const * const i_end)
+{
+  char const *c=i_begin;
+  for(; i_end-c >= 16; c+=16)
+  {
+    __m128i const bytes=_mm_loadu_si128(reinterpret_cast<__m128i const *>(c));
+    __m128i const space=_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), inRange16(bytes, '\t', 4));
+    unsigned const stops=~unsigned(_mm_movemask_epi8(space)) & 0xFFFFu;
+    if(stops != 0)
     {
-      break;
+      return c+__builtin_ctz(stops);
     }
   }
+  return skipSpaceScalar(c, i_end);
+}
+
+__attribute__((target("avx2"))) static __m256i inRange32(__m256i const i_bytes, char const i_low, char const i_span)
+{
+  __m256i const offset=_mm256_sub_epi8(i_bytes, _mm256_set1_epi8(i_low));
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(i_span)), offset);
+}
 
-  if(m_input.eof())
+__attribute__((target("avx2"))) static char const *skipAlnumAVX2(char const * const i_begin, char const * const i_end)
+{
+  char const *c=i_begin;
+  for(; i_end-c >= 32; c+=32)
   {
-    return END();
+    __m256i const bytes=_mm256_loadu_si256(reinterpret_cast<__m256i const *>(c));
+    __m256i const alnum=_mm256_or_si256(inRange32(bytes, '0', 9), inRange32(_mm256_or_si256(bytes, _mm256_set1_epi8(0x20)), 'a', 25));
+    uint32_t const stops=~uint32_t(_mm256_movemask_epi8(alnum));
+    if(stops != 0)
+    {
+      return c+__builtin_ctz(stops);
+    }
   }
+  return skipAlnumSSE2(c, i_end);
+}
 
-  /***** Parse tokens *****/
-  //1: Parse letters/numbers together
-  //2: Parse all other symbols one character at a time
-  //3: Skip whitespace
-  while(!m_input.eof())
+__attribute__((target("avx2"))) static char const *skipSpaceAVX2(char const * const i_begin, char const * const i_end)
+{
+  char const *c=i_begin;
+  for(; i_end-c >= 32; c+=32)
+  {
+    __m256i const bytes=_mm256_loadu_si256(reinterpret_cast<__m256i const *>(c));
+    __m256i const space=_mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')), inRange32(bytes, '\t', 4));
+    uint32_t const stops=~uint32_t(_mm256_movemask_epi8(space));
+    if(stops != 0)
+    {
+      return c+__builtin_ctz(stops);
+    }
+  }
+  return skipSpaceSSE2(c, i_end);
+}
+#endif
+
+static Scanners const &scanners()
+{
+  //Picked once, from what the CPU running us supports
+  static Scanners const chosen=[]()
+  {
+#if defined(__SSE2__)
+    if(__builtin_cpu_supports("avx2"))
+    {
+      return Scanners{skipSpaceAVX2, skipAlnumAVX2};
+    }
+    return Scanners{skipSpaceSSE2, skipAlnumSSE2};
+#else
+    return Scanners{skipSpaceScalar, skipAlnumScalar};
+#endif
+  }();
+  return chosen;
+}
+
+static void lexRange(char const * const i_begin, char const * const i_end, SymbolStack &o_tokens)
+{
+  //Same rules as LexText::pop()
+  Scanners const &scan=scanners();
+  std::string s;
+  char const *c=scan.skipSpace(i_begin, i_end);
+  while(c != i_end)
+  {
+    char const * const tokenEnd=(isAlnumByte(*c) ? scan.skipAlnum(c+1, i_end) : c+1);
+    s.assign(c, tokenEnd);
+    o_tokens.push_back(Symbol(Symbol::Type::T_TERMINAL, s.c_str()));
+    c = scan.skipSpace(tokenEnd, i_end);
+  }
+}
+/**************************************************/
+
+/********************----- CLASS: LexText -----********************/
+LexText::LexText(std::string const &i_filepath)
+:m_input(i_filepath.c_str(), std::ios::binary), m_buffer(BUFFER_BYTES), m_bufferBegin(0), m_bufferEnd(0), m_chunked(false), m_next(0)
+{
+}
+
+LexText::LexText(std::string const &i_filepath, size_t const i_threadCount)
+:m_bufferBegin(0), m_bufferEnd(0), m_chunked(true), m_next(0)
+{
+  int const fd=open(i_filepath.c_str(), O_RDONLY);
+  struct stat fileStat;
+  if(fd < 0 || fstat(fd, &fileStat) != 0)
   {
-    c = m_input.get();
+    if(fd >= 0)
+    {
+      close(fd);
+    }
+    throw std::runtime_error("Unable to open " + i_filepath);
+  }
+
+  /***** Map regular files; read anything else, or what cannot be mapped *****/
+  size_t const threadCount=std::max<size_t>(1, i_threadCount);
+  size_t const sizeBytes=S_ISREG(fileStat.st_mode) ? size_t(fileStat.st_size) : 0;
+  void * const data=(sizeBytes > 0) ? mmap(nullptr, sizeBytes, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  if(data != MAP_FAILED)
+  {
+    madvise(data, sizeBytes, MADV_SEQUENTIAL);
+    this->lexChunks(static_cast<char const *>(data), sizeBytes, threadCount);
+    munmap(data, sizeBytes);
+  }
+  else
+  {
+    std::vector<char> contents;
+    contents.reserve(sizeBytes);
+    std::vector<char> buffer(BUFFER_BYTES);
+    ssize_t readBytes=0;
+    while((readBytes = read(fd, buffer.data(), buffer.size())) != 0)
+    {
+      if(readBytes < 0 && errno != EINTR)
+      {
+        close(fd);
+        throw std::runtime_error("Unable to read " + i_filepath);
+      }
+      contents.insert(contents.end(), buffer.data(), buffer.data()+std::max<ssize_t>(0, readBytes));
+    }
+
+    if(!contents.empty())
+    {
+      this->lexChunks(contents.data(), contents.size(), threadCount);
+    }
+  }
+  close(fd);
 
-    cAlnum = isalnum(c);
-    cSpace = isspace(c);
+  m_tokens.push_back(END());
+}
 
-    if(!cAlnum && s.size() > 0)
+LexText::~LexText()
+{
+}
+
+void LexText::lexChunks(char const * const i_begin, size_t const i_sizeBytes, size_t const i_threadCount)
+{
+  //Nothing in the token rules spans a line, so a newline always ends a
+  //token and every chunk starts in the same state: there is no need to lex
+  //chunks from several speculative start states and reconcile them
+  std::vector<char const *> bounds(1, i_begin);
+  char const * const end=i_begin+i_sizeBytes;
+  for(size_t t=1; t<i_threadCount; ++t)
+  {
+    char const *bound=std::max(i_begin+t*i_sizeBytes/i_threadCount, bounds.back()+1);
+    while(bound != end && *(bound-1) != '\n')
+    {
+      ++bound;
+    }
+    if(bound == end)
     {
       break;
     }
+    bounds.push_back(bound);
+  }
+  bounds.push_back(end);
 
-    if(!cSpace)
+  /***** Lex the chunks side by side, the first on this thread *****/
+  size_t const chunkCount=bounds.size()-1;
+  std::vector<SymbolStack> chunkTokens(chunkCount);
+  std::vector<std::thread> threads;
+  for(size_t c=1; c<chunkCount; ++c)
+  {
+    threads.push_back(std::thread(lexRange, bounds[c], bounds[c+1], std::ref(chunkTokens[c])));
+  }
+  lexRange(bounds[0], bounds[1], chunkTokens[0]);
+  for(std::thread &thread : threads)
+  {
+    thread.join();
+  }
+
+  /***** Chunks end on token boundaries, so their tokens simply follow each other *****/
+  size_t tokenCount=1;
+  for(SymbolStack const &tokens : chunkTokens)
+  {
+    tokenCount += tokens.size();
+  }
+  m_tokens.reserve(tokenCount);
+  for(SymbolStack &tokens : chunkTokens)
+  {
+    for(Symbol &token : tokens)
     {
-      s += c;
+      m_tokens.push_back(std::move(token));
     }
+    SymbolStack().swap(tokens);
+  }
+}
 
-    if(!cAlnum)
+Symbol LexText::pop()
+{
+  /***** Chunked mode lexed everything already *****/
+  if(m_chunked)
+  {
+    if(m_next+1 >= m_tokens.size())
     {
-      break;
+      return END();
     }
+    return std::move(m_tokens[m_next++]);
   }
 
+  Scanners const &scan=scanners();
+
   /***** Skip whitespace *****/
-  while(!m_input.eof())
+  char const *c=scan.skipSpace(m_buffer.data()+m_bufferBegin, m_buffer.data()+m_bufferEnd);
+  while(c == m_buffer.data()+m_bufferEnd)
   {
-    c = m_input.peek();
-    if(isspace(c))
+    if(!this->refill())
     {
-      m_input.get();
+      return END();
     }
-    else
+    c = scan.skipSpace(m_buffer.data(), m_buffer.data()+m_bufferEnd);
+  }
+
+  /***** Parse tokens *****/
+  //1: Parse letters/numbers together, even across refills
+  //2: Parse all other symbols one character at a time
+  std::string s(1, *c);
+  m_bufferBegin = c+1-m_buffer.data();
+  if(isAlnumByte(*c))
+  {
+    char const *tokenEnd=scan.skipAlnum(c+1, m_buffer.data()+m_bufferEnd);
+    s.append(c+1, tokenEnd);
+    while(tokenEnd == m_buffer.data()+m_bufferEnd && this->refill())
     {
-      break;
+      tokenEnd = scan.skipAlnum(m_buffer.data(), m_buffer.data()+m_bufferEnd);
+      s.append(m_buffer.data(), tokenEnd-m_buffer.data());
     }
+    m_bufferBegin = tokenEnd-m_buffer.data();
   }
 
   Symbol outputSymbol(Symbol::Type::T_TERMINAL, s.c_str());
   return outputSymbol;
 }
+
+bool LexText::refill()
+{
+  //Keeps the old contents when the file is done, so positions stay valid
+  m_input.read(m_buffer.data(), m_buffer.size());
+  if(m_input.gcount() <= 0)
+  {
+    return false;
+  }
+  m_bufferBegin = 0;
+  m_bufferEnd = m_input.gcount();
+  return true;
+}
+
+SymbolStack const &LexText::tokens() const
+{
+  return m_tokens;
+}
 /**************************************************/
@@ -6,17 +6,42 @@
 
 #include <fstream>
 #include <string>
+#include <vector>
 
 /********************----- CLASS: LexText -----********************/
+//Tokens are runs of ASCII letters and digits, or any other single non-space
+//character; boundaries are scanned with SSE2 or AVX2 where available.
+//Streams the file by default; given a thread count, the file is mapped, or
+//read whole if it cannot be, and lexed up front in chunks split at
+//newlines, one per thread. The chunked mode throws if it cannot open or
+//read the file
 class LexText : public Lex
 {
 public:
   LexText(std::string const &i_filepath);
+  LexText(std::string const &i_filepath, size_t const i_threadCount);
   virtual ~LexText();
 
   virtual Symbol pop() override;
+
+  //Lexed ahead in chunked mode, END included; pop() moves tokens out of here
+  SymbolStack const &tokens() const;
 private:
+  static size_t const BUFFER_BYTES=65536;
+
+  void lexChunks(char const * const i_begin, size_t const i_sizeBytes, size_t const i_threadCount);
+  bool refill();
+
+  /***** Streaming: the file is read a buffer at a time *****/
   std::ifstream m_input;
+  std::vector<char> m_buffer;
+  size_t m_bufferBegin;
+  size_t m_bufferEnd;
+
+  /***** Chunked *****/
+  bool m_chunked;
+  SymbolStack m_tokens;
+  size_t m_next;
 };
 /**************************************************/
 
@@ -0,0 +1,121 @@
+#include "ParseSession.hpp"
+
+#include <limits>
+
+/********************----- CLASS: ParseSession -----********************/
+ParseSession::ParseSession()
+:m_status(Status::NEED_MORE), m_position(0), m_counting(false), m_shiftCount(0), m_reduceCount(0), m_maxDepth(0), m_trace(nullptr), m_tree(nullptr), m_speculative(false), m_skipping(false), m_skipCount(0), m_recoveryPosition(std::numeric_limits<size_t>::max())
+{
+  this->reset();
+}
+
+void ParseSession::assignStack(ParseSession const &i_session, size_t const i_depth)
+{
+  //Copies the bottom i_depth states of another session's stack, with their
+  //symbols and table; Symbol cannot be assigned, so the symbols are rebuilt
+  //in place
+  m_stackState.assign(i_session.m_stackState.begin(), i_session.m_stackState.begin()+i_depth);
+  m_stackSymbol.clear();
+  for(size_t i=0; i+1<i_depth; ++i)
+  {
+    m_stackSymbol.push_back(i_session.m_stackSymbol[i]);
+  }
+  m_stackBegin.assign(i_session.m_stackBegin.begin(), i_session.m_stackBegin.begin()+(i_depth-1));
+  m_table = i_session.m_table;
+}
+
+bool ParseSession::counting() const
+{
+  return m_counting;
+}
+
+size_t ParseSession::depth() const
+{
+  return m_stackState.size();
+}
+
+LRParseErrorVector const &ParseSession::errors() const
+{
+  return m_errors;
+}
+
+size_t ParseSession::maxDepth() const
+{
+  return m_maxDepth;
+}
+
+size_t ParseSession::position() const
+{
+  return m_position;
+}
+
+size_t ParseSession::reduceCount() const
+{
+  return m_reduceCount;
+}
+
+size_t ParseSession::shiftCount() const
+{
+  return m_shiftCount;
+}
+
+ParseSession::Status ParseSession::status() const
+{
+  return m_status;
+}
+
+LRTrace *ParseSession::trace() const
+{
+  return m_trace;
+}
+
+ParseTree *ParseSession::tree() const
+{
+  return m_tree;
+}
+
+void ParseSession::reset()
+{
+  /***** clear() keeps capacity, so a reused session does not reallocate *****/
+  m_stackState.clear();
+  m_stackSymbol.clear();
+  m_stackBegin.clear();
+  m_insertions.clear();
+  m_errors.clear();
+  m_status = Status::NEED_MORE;
+  m_position = 0;
+  m_table.reset();
+  m_shiftCount = 0;
+  m_reduceCount = 0;
+  m_maxDepth = 1;
+  m_skipping = false;
+  m_skipCount = 0;
+  m_recoveryPosition = std::numeric_limits<size_t>::max();
+  if(m_tree != nullptr)
+  {
+    m_tree->clear();
+  }
+
+  m_stackState.push_back(LRState(0));
+}
+
+//Counting is kept across reset(); switching it on mid-parse counts from there
+void ParseSession::setCounting(bool const i_counting)
+{
+  m_counting = i_counting;
+}
+
+void ParseSession::setTrace(LRTrace * const io_trace)
+{
+  m_trace = io_trace;
+}
+
+void ParseSession::setTree(ParseTree * const io_tree)
+{
+  m_tree = io_tree;
+  if(m_tree != nullptr)
+  {
+    m_tree->clear();
+  }
+}
+/**************************************************/
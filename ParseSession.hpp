@@ -0,0 +1,89 @@
+#ifndef _PARSESESSION_HPP_
+#define _PARSESESSION_HPP_
+
+#include "LRParseError.hpp"
+#include "LRState.hpp"
+#include "LRTrace.hpp"
+#include "ParseTree.hpp"
+#include "Symbol.hpp"
+
+#include <memory>
+#include <vector>
+
+class LRTable;
+
+/********************----- CLASS: ParseSession -----********************/
+//Everything a parse mutates. One session per thread; a session can be
+//reused across inputs and keeps its stack capacity between them.
+//Between LRParser::push() calls the whole parse is suspended in here.
+class ParseSession
+{
+  friend class LRParser;
+public:
+  enum class Status
+  {
+    NEED_MORE,
+    ACCEPTED,
+    ERROR,
+  };
+
+  ParseSession();
+  virtual ~ParseSession(){}
+
+  bool counting() const;
+  size_t depth() const;
+  LRParseErrorVector const &errors() const;
+  size_t maxDepth() const;
+  size_t position() const;
+  size_t reduceCount() const;
+  size_t shiftCount() const;
+  Status status() const;
+  LRTrace *trace() const;
+  ParseTree *tree() const;
+
+  void reset();
+  void setCounting(bool const i_counting);
+  void setTrace(LRTrace * const io_trace);
+  void setTree(ParseTree * const io_tree);
+
+private:
+  ParseSession(ParseSession const &)=delete;
+  ParseSession &operator =(ParseSession const &)=delete;
+
+  void assignStack(ParseSession const &i_session, size_t const i_depth);
+
+  LRStateStack m_stackState;
+  SymbolStack m_stackSymbol;
+  std::vector<size_t> m_stackBegin; //Input position where each stacked symbol starts
+  SymbolStack m_insertions;         //Tokens a repair inserts before the current one
+  LRParseErrorVector m_errors;
+  Status m_status;
+  size_t m_position;
+
+  //The table the stacked states belong to, taken from the parser on the
+  //first push after reset(), so an update() does not change it mid-parse
+  std::shared_ptr<LRTable const> m_table;
+
+  /***** Counters, only kept while counting is on; see LRStats::addParse() *****/
+  bool m_counting;
+  size_t m_shiftCount;
+  size_t m_reduceCount;
+  size_t m_maxDepth;
+
+  /***** Steps are recorded while a trace is attached; kept across reset() *****/
+  LRTrace *m_trace;
+
+  /***** Built while a tree is attached; reset() clears it for the next parse *****/
+  ParseTree *m_tree;
+
+  /***** Chunks of a parallel parse stop at the first error instead of recovering *****/
+  bool m_speculative;
+
+  /***** Panic-mode recovery in progress *****/
+  bool m_skipping;
+  size_t m_skipCount;
+  size_t m_recoveryPosition;
+};
+/**************************************************/
+
+#endif /* _PARSESESSION_HPP_ */
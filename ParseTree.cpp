@@ -0,0 +1,138 @@
+#include "ParseTree.hpp"
+
+#include <limits>
+
+/********************----- CLASS: ParseTree::Cursor -----********************/
+ParseTree::Cursor::Cursor(ParseTree const * const i_tree, size_t const i_index, size_t const i_first)
+:m_tree(i_tree), m_index(i_index), m_first(i_first)
+{
+}
+
+bool ParseTree::Cursor::isToken() const
+{
+  return (this->node().production == ParseTree::TOKEN);
+}
+
+bool ParseTree::Cursor::valid() const
+{
+  return (m_index != std::numeric_limits<size_t>::max());
+}
+
+size_t ParseTree::Cursor::index() const
+{
+  return m_index;
+}
+
+ParseTree::Node const &ParseTree::Cursor::node() const
+{
+  return (*m_tree)[m_index];
+}
+
+ParseTree::Cursor ParseTree::Cursor::lastChild() const
+{
+  Node const &current=this->node();
+  if(current.childCount == 0)
+  {
+    return Cursor(m_tree, std::numeric_limits<size_t>::max(), 0);
+  }
+
+  return Cursor(m_tree, m_index-1, m_index+1-current.size);
+}
+
+ParseTree::Cursor ParseTree::Cursor::previousSibling() const
+{
+  size_t const size=this->node().size;
+  if(m_index < m_first+size)
+  {
+    return Cursor(m_tree, std::numeric_limits<size_t>::max(), 0);
+  }
+
+  return Cursor(m_tree, m_index-size, m_first);
+}
+/**************************************************/
+
+/********************----- CLASS: ParseTree -----********************/
+uint32_t const ParseTree::TOKEN;
+
+ParseTree::ParseTree()
+{
+}
+
+void ParseTree::clear()
+{
+  m_nodes.clear();
+  m_roots.clear();
+}
+
+ParseTree::Node const *ParseTree::data() const
+{
+  return m_nodes.data();
+}
+
+bool ParseTree::empty() const
+{
+  return m_nodes.empty();
+}
+
+void ParseTree::reduce(uint32_t const i_production, size_t const i_childCount, size_t const i_position)
+{
+  //The children are the newest roots and sit right before the new node
+  Node node={i_production, uint32_t(i_childCount), 1, uint32_t(i_position), uint32_t(i_position)};
+  if(i_childCount > 0)
+  {
+    Node const &firstChild=m_nodes[m_roots[m_roots.size()-i_childCount]];
+    Node const &lastChild=m_nodes[m_roots.back()];
+    node.size += uint32_t(m_nodes.size()-(m_roots[m_roots.size()-i_childCount]+1-firstChild.size));
+    node.tokenBegin = firstChild.tokenBegin;
+    node.tokenEnd = lastChild.tokenEnd;
+    m_roots.resize(m_roots.size()-i_childCount);
+  }
+
+  m_roots.push_back(uint32_t(m_nodes.size()));
+  m_nodes.push_back(node);
+}
+
+ParseTree::Cursor ParseTree::root() const
+{
+  if(m_nodes.empty())
+  {
+    return Cursor(this, std::numeric_limits<size_t>::max(), 0);
+  }
+
+  return Cursor(this, m_nodes.size()-1, 0);
+}
+
+void ParseTree::shift(size_t const i_position)
+{
+  m_roots.push_back(uint32_t(m_nodes.size()));
+  m_nodes.push_back(Node{TOKEN, 0, 1, uint32_t(i_position), uint32_t(i_position+1)});
+}
+
+size_t ParseTree::size() const
+{
+  return m_nodes.size();
+}
+
+size_t ParseTree::sizeBytes() const
+{
+  return sizeof(ParseTree) + m_nodes.capacity()*sizeof(Node) + m_roots.capacity()*sizeof(uint32_t);
+}
+
+void ParseTree::truncate(size_t const i_rootCount)
+{
+  //Symbols dropped by error recovery take their subtrees with them; they are
+  //the newest nodes, so the array just shrinks back to the newest kept root
+  if(i_rootCount >= m_roots.size())
+  {
+    return;
+  }
+
+  m_roots.resize(i_rootCount);
+  m_nodes.resize(m_roots.empty() ? 0 : m_roots.back()+1);
+}
+
+ParseTree::Node const &ParseTree::operator[](size_t const i_index) const
+{
+  return m_nodes[i_index];
+}
+/**************************************************/
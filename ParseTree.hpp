@@ -0,0 +1,73 @@
+#ifndef _PARSETREE_HPP_
+#define _PARSETREE_HPP_
+
+#include <cstdint>
+#include <stddef.h>
+#include <vector>
+
+/********************----- CLASS: ParseTree -----********************/
+//Parse tree as one flat array of nodes in postfix (reduction) order: every
+//node follows its children, and the root is the last node. Attach one to a
+//ParseSession to record into it; clear() keeps the capacity, so a tree
+//reused across parses stops allocating once it has grown to fit.
+class ParseTree
+{
+public:
+  static uint32_t const TOKEN=UINT32_MAX;
+
+  struct Node
+  {
+    uint32_t production; //Grammar production index, or TOKEN for a shifted token
+    uint32_t childCount;
+    uint32_t size;       //Nodes in this subtree, itself included
+    uint32_t tokenBegin; //Input positions covered, end exclusive
+    uint32_t tokenEnd;
+  };
+
+  //Walks children last to first, since that is the direction postfix order
+  //can step in without searching
+  class Cursor
+  {
+    friend class ParseTree;
+  public:
+    bool isToken() const;
+    bool valid() const;
+    size_t index() const;
+    Node const &node() const;
+
+    Cursor lastChild() const;
+    Cursor previousSibling() const;
+  private:
+    Cursor(ParseTree const * const i_tree, size_t const i_index, size_t const i_first);
+
+    ParseTree const *m_tree;
+    size_t m_index;
+    size_t m_first; //First index inside the parent; siblings stop there
+  };
+
+  ParseTree();
+  virtual ~ParseTree(){}
+
+  void clear();
+  Node const *data() const;
+  bool empty() const;
+  Cursor root() const;
+  size_t size() const;
+  size_t sizeBytes() const;
+  Node const &operator[](size_t const i_index) const;
+
+  /***** Building, driven by LRParser *****/
+  void reduce(uint32_t const i_production, size_t const i_childCount, size_t const i_position);
+  void shift(size_t const i_position);
+  void truncate(size_t const i_rootCount);
+
+private:
+  ParseTree(ParseTree const &)=delete;
+  ParseTree &operator =(ParseTree const &)=delete;
+
+  std::vector<Node> m_nodes;
+  std::vector<uint32_t> m_roots; //Node of each symbol on the parse stack
+};
+/**************************************************/
+
+#endif /* _PARSETREE_HPP_ */
@@ -4,6 +4,7 @@
 #include "Symbol.hpp"
 #include "SymbolList.hpp"
 
+#include <deque>
 #include <vector>
 
 /********************----- CLASS: Production -----********************/
@@ -23,7 +24,7 @@ private:
 };
 /**************************************************/
 
-typedef std::vector<Production> ProductionVector;
+typedef std::deque<Production> ProductionDeque;
 typedef std::vector<Production const *> ProductionConstPtrVector;
 
 /********************----- Operators -----********************/
@@ -5,35 +5,38 @@
 
 /********************----- CLASS: Symbol -----********************/
 Symbol::Symbol(Symbol::Type const &i_type, char const * const i_value)
-:m_type(i_type), m_value(nullptr), m_valueSizeBytes(0)
+:m_type(i_type), m_valueSizeBytes(0)
 {
   if(i_value != nullptr)
   {
     size_t const inputValueLength = strlen(i_value);
     if(inputValueLength > 0)
     {
-      m_value = new uint8_t[inputValueLength+1];
-      memcpy(m_value, i_value, inputValueLength+1);
-      m_valueSizeBytes = inputValueLength+1;
+      this->assign(reinterpret_cast<uint8_t const *>(i_value), inputValueLength+1);
     }
   }
 }
 
 Symbol::Symbol(Symbol const &i_symbol)
-:m_type(i_symbol.m_type), m_value(nullptr), m_valueSizeBytes(0)
+:m_type(i_symbol.m_type), m_valueSizeBytes(0)
 {
   if(i_symbol.m_valueSizeBytes > 0)
   {
-    m_value = new uint8_t[i_symbol.m_valueSizeBytes];
-    memcpy(m_value, i_symbol.m_value, i_symbol.m_valueSizeBytes);
-    m_valueSizeBytes = i_symbol.m_valueSizeBytes;
+    this->assign(i_symbol.value(), i_symbol.m_valueSizeBytes);
   }
 }
 
 Symbol::Symbol(Symbol &&i_symbol)
-:m_type(i_symbol.m_type), m_value(i_symbol.m_value), m_valueSizeBytes(i_symbol.m_valueSizeBytes)
+:m_type(i_symbol.m_type), m_valueSizeBytes(i_symbol.m_valueSizeBytes)
 {
-  i_symbol.m_value = nullptr;
+  if(m_valueSizeBytes > INLINE_VALUE_BYTES)
+  {
+    m_heapValue = i_symbol.m_heapValue;
+  }
+  else
+  {
+    memcpy(m_inlineValue, i_symbol.m_inlineValue, m_valueSizeBytes);
+  }
   i_symbol.m_valueSizeBytes = 0;
 }
 
@@ -42,13 +45,25 @@ Symbol::~Symbol()
   this->clear();
 }
 
+void Symbol::assign(uint8_t const * const i_value, size_t const i_valueSizeBytes)
+{
+  uint8_t *storage=m_inlineValue;
+  if(i_valueSizeBytes > INLINE_VALUE_BYTES)
+  {
+    m_heapValue = new uint8_t[i_valueSizeBytes];
+    storage = m_heapValue;
+  }
+  memcpy(storage, i_value, i_valueSizeBytes);
+  m_valueSizeBytes = uint32_t(i_valueSizeBytes);
+}
+
 void Symbol::clear()
 {
-  if(m_value != nullptr)
+  if(m_valueSizeBytes > INLINE_VALUE_BYTES)
   {
-    delete[] m_value;
-    m_valueSizeBytes = 0;
+    delete[] m_heapValue;
   }
+  m_valueSizeBytes = 0;
   m_type = Symbol::Type::T_NONE;
 }
 
@@ -59,29 +74,30 @@ CompareResult Symbol::compare(Symbol const &i_otherSymbol) const
     return CompareResult::EQUAL;
   }
 
-  if(this->sizeBytes() < i_otherSymbol.sizeBytes())
+  if(m_type < i_otherSymbol.m_type)
   {
     return CompareResult::LESS;
   }
-  else if(this->sizeBytes() > i_otherSymbol.sizeBytes())
+  else if(m_type > i_otherSymbol.m_type)
   {
     return CompareResult::GREATER;
   }
 
-  if(m_value == nullptr && i_otherSymbol.m_value != nullptr)
+  if(this->sizeBytes() < i_otherSymbol.sizeBytes())
   {
     return CompareResult::LESS;
   }
-  else if(m_value != nullptr && i_otherSymbol.m_value == nullptr)
+  else if(this->sizeBytes() > i_otherSymbol.sizeBytes())
   {
     return CompareResult::GREATER;
   }
-  else if(m_value == i_otherSymbol.m_value)
+
+  if(m_valueSizeBytes == 0)
   {
     return CompareResult::EQUAL;
   }
 
-  int const memResult = memcmp(m_value, i_otherSymbol.m_value, m_valueSizeBytes);
+  int const memResult = memcmp(this->value(), i_otherSymbol.value(), m_valueSizeBytes);
   if(memResult < 0)
   {
     return CompareResult::LESS;
@@ -94,6 +110,20 @@ CompareResult Symbol::compare(Symbol const &i_otherSymbol) const
   return CompareResult::EQUAL;
 }
 
+size_t Symbol::hash() const
+{
+  //FNV-1a over the type and the value bytes
+  size_t hashValue=2166136261u;
+  hashValue = (hashValue ^ size_t(enum_value(m_type))) * 16777619u;
+  uint8_t const * const value=this->value();
+  for(size_t i=0; i<m_valueSizeBytes; ++i)
+  {
+    hashValue = (hashValue ^ value[i]) * 16777619u;
+  }
+
+  return hashValue;
+}
+
 bool Symbol::isEND() const
 {
   return (m_type == Symbol::Type::T_END);
@@ -146,13 +176,18 @@ std::string Symbol::toString() const
   if(shouldOutputValue)
   {
     outputValue += "(";
-    outputValue += std::string(reinterpret_cast<char const * const>(m_value), m_valueSizeBytes-1);
+    outputValue += std::string(reinterpret_cast<char const *>(this->value()), m_valueSizeBytes-1);
     outputValue += ")";
   }
 
   return outputValue;
 }
 
+uint8_t const *Symbol::value() const
+{
+  return (m_valueSizeBytes > INLINE_VALUE_BYTES) ? m_heapValue : m_inlineValue;
+}
+
 bool Symbol::operator <(Symbol const &i_otherSymbol) const
 {
   return (this->compare(i_otherSymbol) == CompareResult::LESS);
@@ -177,11 +212,17 @@ Symbol &Symbol::operator =(Symbol &&i_symbol)
 
   this->clear();
   m_type = i_symbol.m_type;
-  m_value = i_symbol.m_value;
   m_valueSizeBytes = i_symbol.m_valueSizeBytes;
+  if(m_valueSizeBytes > INLINE_VALUE_BYTES)
+  {
+    m_heapValue = i_symbol.m_heapValue;
+  }
+  else
+  {
+    memcpy(m_inlineValue, i_symbol.m_inlineValue, m_valueSizeBytes);
+  }
 
   i_symbol.m_type = Symbol::Type::T_NONE;
-  i_symbol.m_value = nullptr;
   i_symbol.m_valueSizeBytes = 0;
 
   return (*this);
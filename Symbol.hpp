@@ -3,10 +3,12 @@
 
 #include "global.hpp"
 
+#include <cstdint>
+#include <limits>
 #include <set>
-#include <stack>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class Symbol;
 
@@ -29,6 +31,7 @@ public:
   virtual ~Symbol();
 
   CompareResult compare(Symbol const &i_symbol) const;
+  size_t hash() const;
 
   bool isEND() const;
   bool isEpsilon() const;
@@ -44,11 +47,21 @@ public:
   bool operator ==(Symbol const &i_otherSymbol) const;
   Symbol &operator=(Symbol &&i_symbol);
 private:
+  //Values this long or shorter, terminator included, are stored in the
+  //symbol itself; most terminals and many nonterminals fit
+  static size_t const INLINE_VALUE_BYTES=16;
+
+  void assign(uint8_t const * const i_value, size_t const i_valueSizeBytes);
   void clear();
+  uint8_t const *value() const;
 
   Symbol::Type m_type;
-  uint8_t *m_value;
-  size_t m_valueSizeBytes;
+  uint32_t m_valueSizeBytes;
+  union
+  {
+    uint8_t *m_heapValue;
+    uint8_t m_inlineValue[INLINE_VALUE_BYTES];
+  };
 };
 /**************************************************/
 
@@ -67,7 +80,7 @@ namespace std
   {
     size_t operator ()(Symbol const &i_symbol) const
     {
-      return i_symbol.sizeBytes();
+      return i_symbol.hash();
     }
   };
 }
@@ -76,7 +89,12 @@ namespace std
 /********************----- Types -----********************/
 typedef std::set<Symbol> SymbolSet;
 typedef std::unordered_map<Symbol, SymbolSet> SymbolMap;
-typedef std::stack<Symbol> SymbolStack;
+typedef std::vector<Symbol> SymbolStack;
+
+//Dense index of a symbol within its Grammar, see Grammar::symbolId()
+typedef uint32_t SymbolId;
+typedef std::vector<SymbolId> SymbolIdVector;
+SymbolId const SYMBOLID_INVALID=std::numeric_limits<SymbolId>::max();
 /**************************************************/
 
 /********************----- Operators -----********************/
@@ -1,90 +1,228 @@
 #include "SymbolList.hpp"
 #include "global.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <stdexcept>
 
-/********************----- CLASS: SymbolList -----********************/
-SymbolList::SymbolList(Symbol &&i_symbol)
-:m_flags(SymbolList::Flags::F_DEFAULT), m_symbolArray(nullptr), m_symbolCount(0)
+/********************----- CLASS: SymbolListView -----********************/
+SymbolListView::SymbolListView(SymbolList const &i_symbolList)
+:m_symbolArray(i_symbolList.data()), m_symbolCount(i_symbolList.count())
 {
-  if(i_symbol.isEpsilon())
+}
+
+SymbolListView::SymbolListView(Symbol const *i_symbolArray, size_t const i_symbolCount)
+:m_symbolArray(i_symbolArray), m_symbolCount(i_symbolCount)
+{
+}
+
+SymbolListView::SymbolListView()
+:m_symbolArray(nullptr), m_symbolCount(0)
+{
+}
+
+Symbol const *SymbolListView::begin() const
+{
+  return m_symbolArray;
+}
+
+Symbol const *SymbolListView::end() const
+{
+  return m_symbolArray+m_symbolCount;
+}
+
+CompareResult SymbolListView::compare(SymbolListView const &i_otherView) const
+{
+  /***** Check symbol count *****/
+  if(m_symbolCount < i_otherView.m_symbolCount)
   {
-    m_flags = static_cast<SymbolList::Flags>(enum_value(m_flags) | enum_value(SymbolList::Flags::F_EPSILON));
+    return CompareResult::LESS;
   }
-  m_symbolArray = reinterpret_cast<Symbol*>(::operator new(sizeof(Symbol)));
-  m_symbolArray = new(m_symbolArray) Symbol(std::forward<Symbol>(i_symbol));
-  m_symbolCount = 1;
+  else if(m_symbolCount > i_otherView.m_symbolCount)
+  {
+    return CompareResult::GREATER;
+  }
+
+  /***** Same symbols *****/
+  if(m_symbolArray == i_otherView.m_symbolArray)
+  {
+    return CompareResult::EQUAL;
+  }
+
+  /***** Check symbols *****/
+  for(size_t i=0; i<m_symbolCount; ++i)
+  {
+    CompareResult cr=m_symbolArray[i].compare(i_otherView.m_symbolArray[i]);
+    if(cr == CompareResult::LESS)
+    {
+      return CompareResult::LESS;
+    }
+    else if(cr == CompareResult::GREATER)
+    {
+      return CompareResult::GREATER;
+    }
+  }
+
+  /***** They are equal *****/
+  return CompareResult::EQUAL;
 }
 
-SymbolList::SymbolList(Symbol const &i_symbol)
-:m_flags(SymbolList::Flags::F_DEFAULT), m_symbolArray(nullptr), m_symbolCount(0)
+bool SymbolListView::containsEpsilon() const
 {
-  if(i_symbol.isEpsilon())
+  if(m_symbolCount < 1)
   {
-    m_flags = static_cast<SymbolList::Flags>(enum_value(m_flags) | enum_value(SymbolList::Flags::F_EPSILON));
+    return true;
   }
 
-  m_symbolArray = reinterpret_cast<Symbol*>(::operator new(sizeof(Symbol)));
-  m_symbolArray = new(m_symbolArray) Symbol(i_symbol);
-  m_symbolCount = 1;
+  for(size_t i=0; i<m_symbolCount; ++i)
+  {
+    if(m_symbolArray[i].isEpsilon())
+    {
+      return true;
+    }
+  }
+
+  return false;
 }
 
-SymbolList::SymbolList(SymbolList &&i_symbolList)
-:m_flags(i_symbolList.m_flags), m_symbolArray(i_symbolList.m_symbolArray), m_symbolCount(i_symbolList.m_symbolCount)
+size_t SymbolListView::hash() const
 {
-  /***** Remove ownership from other list *****/
-  i_symbolList.m_symbolArray = nullptr;
-  i_symbolList.m_symbolCount = 0;
+  //SymbolList::hash() defers to this, so a view and an equal list agree
+  size_t hashValue=m_symbolCount;
+  for(size_t i=0; i<m_symbolCount; ++i)
+  {
+    hashValue = hashValue*31 + m_symbolArray[i].hash();
+  }
+
+  return hashValue;
 }
 
-SymbolList::SymbolList(SymbolList const &i_symbolList)
-:m_flags(i_symbolList.m_flags), m_symbolArray(nullptr), m_symbolCount(0)
+size_t SymbolListView::count() const
 {
-  size_t const nextSymbolCount = i_symbolList.count();
-  Symbol *const nextSymbolArray = reinterpret_cast<Symbol*>(::operator new(sizeof(Symbol) * nextSymbolCount));
+  return m_symbolCount;
+}
 
-  /***** Copy remote array *****/
-  for(size_t i=0; i<i_symbolList.m_symbolCount; ++i)
+Symbol const &SymbolListView::get(size_t const i_index) const
+{
+  if(i_index >= m_symbolCount)
   {
-    new (&nextSymbolArray[i]) Symbol(i_symbolList.m_symbolArray[i]);
+    throw std::out_of_range(std::to_string(i_index));
   }
 
-  /***** Finish *****/
-  m_symbolArray = nextSymbolArray;
-  m_symbolCount = nextSymbolCount;
+  return m_symbolArray[i_index];
 }
-SymbolList::SymbolList(SymbolList const &i_symbolList, size_t const i_position, size_t const i_length)
-:m_flags(SymbolList::Flags::F_DEFAULT), m_symbolArray(nullptr), m_symbolCount(0)
+
+bool SymbolListView::isEmpty() const
 {
-  size_t copyLength = i_length;
-  size_t copyPosition = i_position;
+  return (m_symbolCount == 0);
+}
 
-  if(copyPosition > i_symbolList.count())
+SymbolListView SymbolListView::sublist(size_t const i_position, size_t const i_length) const
+{
+  if(i_position > m_symbolCount)
   {
-    throw std::out_of_range(std::to_string(copyPosition));
+    throw std::out_of_range(std::to_string(i_position));
   }
 
+  size_t viewLength = i_length;
   if(i_length == std::numeric_limits<size_t>::max())
   {
-    copyLength = i_symbolList.count()-copyPosition;
+    viewLength = m_symbolCount-i_position;
   }
-  else if((copyPosition+copyLength) > i_symbolList.count())
+  else if((i_position+i_length) > m_symbolCount)
   {
-    throw std::out_of_range(std::to_string(copyPosition+copyLength));
+    throw std::out_of_range(std::to_string(i_position+i_length));
   }
 
-  if(copyLength < 1)
+  return SymbolListView(m_symbolArray+i_position, viewLength);
+}
+
+std::string SymbolListView::toString() const
+{
+  std::string outputString;
+  for(size_t i=0; i<m_symbolCount; ++i)
   {
-    return;
+    if(i!=0) outputString += " ";
+    outputString += m_symbolArray[i].toString();
+  }
+
+  return outputString;
+}
+
+Symbol const &SymbolListView::operator [](size_t const i_index) const
+{
+  return this->get(i_index);
+}
+
+bool SymbolListView::operator <(SymbolListView const &i_otherView) const
+{
+  return (this->compare(i_otherView)==CompareResult::LESS);
+}
+
+bool SymbolListView::operator >(SymbolListView const &i_otherView) const
+{
+  return (this->compare(i_otherView)==CompareResult::GREATER);
+}
+
+bool SymbolListView::operator ==(SymbolListView const &i_otherView) const
+{
+  return (this->compare(i_otherView)==CompareResult::EQUAL);
+}
+
+bool SymbolListView::operator !=(SymbolListView const &i_otherView) const
+{
+  return !(*this == i_otherView);
+}
+/**************************************************/
+
+/********************----- CLASS: SymbolList -----********************/
+SymbolList::SymbolList(Symbol &&i_symbol)
+:SymbolList()
+{
+  if(i_symbol.isEpsilon())
+  {
+    m_flags = static_cast<SymbolList::Flags>(enum_value(m_flags) | enum_value(SymbolList::Flags::F_EPSILON));
   }
+  new(m_symbolArray) Symbol(std::forward<Symbol>(i_symbol));
+  m_symbolCount = 1;
+}
+
+SymbolList::SymbolList(Symbol const &i_symbol)
+:SymbolList()
+{
+  if(i_symbol.isEpsilon())
+  {
+    m_flags = static_cast<SymbolList::Flags>(enum_value(m_flags) | enum_value(SymbolList::Flags::F_EPSILON));
+  }
+  new(m_symbolArray) Symbol(i_symbol);
+  m_symbolCount = 1;
+}
+
+SymbolList::SymbolList(SymbolList &&i_symbolList)
+:SymbolList()
+{
+  *this = std::forward<SymbolList>(i_symbolList);
+}
+
+SymbolList::SymbolList(SymbolList const &i_symbolList)
+:SymbolList()
+{
+  *this = i_symbolList;
+}
+
+SymbolList::SymbolList(SymbolList const &i_symbolList, size_t const i_position, size_t const i_length)
+:SymbolList(SymbolListView(i_symbolList).sublist(i_position, i_length))
+{
+}
 
-  m_symbolArray = reinterpret_cast<Symbol*>(::operator new(sizeof(Symbol)*copyLength));
-  for(size_t i=0; i<copyLength; ++i)
+SymbolList::SymbolList(SymbolListView const &i_symbolView)
+:SymbolList()
+{
+  this->reserve(i_symbolView.count());
+  for(Symbol const &s : i_symbolView)
   {
-    Symbol const &otherListSymbol=i_symbolList[copyPosition+i];
-    new(&m_symbolArray[i]) Symbol(otherListSymbol);
-    if(otherListSymbol.isEpsilon())
+    new(&m_symbolArray[m_symbolCount]) Symbol(s);
+    if(s.isEpsilon())
     {
       m_flags = static_cast<SymbolList::Flags>(enum_value(m_flags) | enum_value(SymbolList::Flags::F_EPSILON));
     }
@@ -93,7 +231,7 @@ SymbolList::SymbolList(SymbolList const &i_symbolList, size_t const i_position,
 }
 
 SymbolList::SymbolList()
-:m_symbolArray(nullptr), m_symbolCount(0)
+:m_flags(SymbolList::Flags::F_DEFAULT), m_symbolCount(0), m_symbolCapacity(INLINE_SYMBOLS), m_symbolArray(this->inlineSymbols())
 {
 }
 
@@ -104,27 +242,35 @@ SymbolList::~SymbolList()
 
 void SymbolList::append(SymbolList &&i_symbolList)
 {
+  if(this == &i_symbolList)
+  {
+    this->append(static_cast<SymbolList const &>(i_symbolList));
+    return;
+  }
+
   SymbolList::Flags nextFlags = static_cast<SymbolList::Flags>(enum_value(m_flags) | enum_value(i_symbolList.m_flags));
-  size_t const nextSymbolCount = m_symbolCount+i_symbolList.count();
-  Symbol *const nextSymbolArray = reinterpret_cast<Symbol*>(::operator new(sizeof(Symbol) * nextSymbolCount));
+  if(i_symbolList.m_symbolCount == 0)
+  {
+    m_flags = nextFlags;
+    return;
+  }
 
-  /***** Move local array *****/
-  for(size_t i=0; i<m_symbolCount; ++i)
+  /***** Nothing local to keep - take the remote array as it is *****/
+  if(m_symbolCount == 0)
   {
-    new (&nextSymbolArray[i]) Symbol(std::move(m_symbolArray[i]));
+    *this = std::forward<SymbolList>(i_symbolList);
+    m_flags = nextFlags;
+    return;
   }
 
   /***** Move remote array *****/
+  this->grow(m_symbolCount+i_symbolList.m_symbolCount);
   for(size_t i=0; i<i_symbolList.m_symbolCount; ++i)
   {
-    new (&nextSymbolArray[m_symbolCount+i]) Symbol(std::move(i_symbolList.m_symbolArray[i]));
+    new (&m_symbolArray[m_symbolCount+i]) Symbol(std::move(i_symbolList.m_symbolArray[i]));
   }
-
-  /***** Finalize local array *****/
-  this->clear();
+  m_symbolCount += i_symbolList.m_symbolCount;
   m_flags = nextFlags;
-  m_symbolArray = nextSymbolArray;
-  m_symbolCount = nextSymbolCount;
 
   /***** Finalize remote array *****/
   i_symbolList.clear();
@@ -133,78 +279,91 @@ void SymbolList::append(SymbolList &&i_symbolList)
 void SymbolList::append(SymbolList const &i_symbolList)
 {
   SymbolList::Flags nextFlags = static_cast<SymbolList::Flags>(enum_value(m_flags) | enum_value(i_symbolList.m_flags));
-  size_t const nextSymbolCount = m_symbolCount+i_symbolList.count();
-  Symbol *const nextSymbolArray = reinterpret_cast<Symbol*>(::operator new(sizeof(Symbol) * nextSymbolCount));
-
-  /***** Move local array *****/
-  for(size_t i=0; i<m_symbolCount; ++i)
+  if(i_symbolList.m_symbolCount == 0)
   {
-    new (&nextSymbolArray[i]) Symbol(std::move(m_symbolArray[i]));
+    m_flags = nextFlags;
+    return;
   }
 
   /***** Copy remote array *****/
-  for(size_t i=0; i<i_symbolList.m_symbolCount; ++i)
+  //Re-read the remote array after growing; it is our own when self-appending
+  size_t const appendCount = i_symbolList.m_symbolCount;
+  this->grow(m_symbolCount+appendCount);
+  for(size_t i=0; i<appendCount; ++i)
   {
-    new (&nextSymbolArray[m_symbolCount+i]) Symbol(i_symbolList.m_symbolArray[i]);
+    new (&m_symbolArray[m_symbolCount+i]) Symbol(i_symbolList.m_symbolArray[i]);
   }
-
-  /***** Finalize local array *****/
-  this->clear();
+  m_symbolCount += appendCount;
   m_flags = nextFlags;
-  m_symbolArray = nextSymbolArray;
-  m_symbolCount = nextSymbolCount;
+}
+
+size_t SymbolList::capacity() const
+{
+  return m_symbolCapacity;
 }
 
 void SymbolList::clear()
 {
   m_flags = SymbolList::Flags::F_DEFAULT;
-  if(m_symbolArray != nullptr)
+  for(size_t i=0; i<m_symbolCount; ++i)
   {
-    for(size_t i=0; i<m_symbolCount; ++i)
-    {
-      m_symbolArray[i].~Symbol();
-    }
-    m_symbolCount = 0;
+    m_symbolArray[i].~Symbol();
+  }
+  m_symbolCount = 0;
 
+  if(m_symbolArray != this->inlineSymbols())
+  {
     ::operator delete(m_symbolArray);
-    m_symbolArray = nullptr;
+    m_symbolArray = this->inlineSymbols();
+    m_symbolCapacity = INLINE_SYMBOLS;
   }
 }
 
-CompareResult SymbolList::compare(SymbolList const &i_symbolList) const
+void SymbolList::grow(size_t const i_symbolCount)
 {
-  /***** Same thing *****/
-  if(this == &i_symbolList)
+  //Doubling keeps a run of appends linear overall
+  if(i_symbolCount > m_symbolCapacity)
   {
-    return CompareResult::LESS;
+    this->reserve(std::max<size_t>(i_symbolCount, size_t(m_symbolCapacity)*2));
   }
+}
 
-  /***** Check symbol count *****/
-  if(m_symbolCount < i_symbolList.m_symbolCount)
+void SymbolList::reserve(size_t const i_symbolCount)
+{
+  if(i_symbolCount <= m_symbolCapacity)
   {
-    return CompareResult::GREATER;
+    return;
   }
-  else if(m_symbolCount > i_symbolList.m_symbolCount)
+  if(i_symbolCount > std::numeric_limits<uint32_t>::max())
   {
-    return CompareResult::GREATER;
+    throw std::length_error(std::to_string(i_symbolCount));
   }
 
-  /***** Check symbols *****/
+  /***** Move local array *****/
+  Symbol *const nextSymbolArray = reinterpret_cast<Symbol*>(::operator new(sizeof(Symbol) * i_symbolCount));
   for(size_t i=0; i<m_symbolCount; ++i)
   {
-    CompareResult cr=this->get(i).compare(i_symbolList.get(i));
-    if(cr == CompareResult::LESS)
-    {
-      return CompareResult::LESS;
-    }
-    else if(cr == CompareResult::GREATER)
-    {
-      return CompareResult::GREATER;
-    }
+    new (&nextSymbolArray[i]) Symbol(std::move(m_symbolArray[i]));
+    m_symbolArray[i].~Symbol();
   }
 
-  /***** They are equal *****/
-  return CompareResult::EQUAL;
+  /***** Finalize local array *****/
+  if(m_symbolArray != this->inlineSymbols())
+  {
+    ::operator delete(m_symbolArray);
+  }
+  m_symbolArray = nextSymbolArray;
+  m_symbolCapacity = uint32_t(i_symbolCount);
+}
+
+CompareResult SymbolList::compare(SymbolListView const &i_otherView) const
+{
+  return SymbolListView(*this).compare(i_otherView);
+}
+
+size_t SymbolList::hash() const
+{
+  return SymbolListView(*this).hash();
 }
 
 bool SymbolList::containsEpsilon() const
@@ -222,6 +381,11 @@ size_t SymbolList::count() const
   return m_symbolCount;
 }
 
+Symbol const *SymbolList::data() const
+{
+  return m_symbolArray;
+}
+
 Symbol const &SymbolList::get(size_t const i_index) const
 {
   if(i_index >= m_symbolCount)
@@ -232,26 +396,24 @@ Symbol const &SymbolList::get(size_t const i_index) const
   return m_symbolArray[i_index];
 }
 
+Symbol *SymbolList::inlineSymbols()
+{
+  return reinterpret_cast<Symbol*>(m_inlineStorage);
+}
+
 bool SymbolList::isEmpty() const
 {
   return (this->count() == 0);
 }
 
-SymbolList SymbolList::sublist(size_t const i_position, size_t const i_length) const
+SymbolListView SymbolList::sublist(size_t const i_position, size_t const i_length) const
 {
-  return SymbolList(*this, i_position, i_length);
+  return SymbolListView(*this).sublist(i_position, i_length);
 }
 
 std::string SymbolList::toString() const
 {
-  std::string outputString;
-  for(size_t i=0; i<this->count(); ++i)
-  {
-    if(i!=0) outputString += " ";
-    outputString += this->get(i).toString();
-  }
-
-  return outputString;
+  return SymbolListView(*this).toString();
 }
 
 Symbol const &SymbolList::operator [](size_t const i_index) const
@@ -259,24 +421,24 @@ Symbol const &SymbolList::operator [](size_t const i_index) const
   return this->get(i_index);
 }
 
-bool SymbolList::operator <(SymbolList const &i_symbolList) const
+bool SymbolList::operator <(SymbolListView const &i_otherView) const
 {
-  return (this->compare(i_symbolList)==CompareResult::LESS);
+  return (this->compare(i_otherView)==CompareResult::LESS);
 }
 
-bool SymbolList::operator >(SymbolList const &i_symbolList) const
+bool SymbolList::operator >(SymbolListView const &i_otherView) const
 {
-  return (this->compare(i_symbolList)==CompareResult::GREATER);
+  return (this->compare(i_otherView)==CompareResult::GREATER);
 }
 
-bool SymbolList::operator ==(SymbolList const &i_symbolList) const
+bool SymbolList::operator ==(SymbolListView const &i_otherView) const
 {
-  return (this->compare(i_symbolList)==CompareResult::EQUAL);
+  return (this->compare(i_otherView)==CompareResult::EQUAL);
 }
 
-bool SymbolList::operator !=(SymbolList const &i_symbolList) const
+bool SymbolList::operator !=(SymbolListView const &i_otherView) const
 {
-  return !(*this == i_symbolList);
+  return !(*this == i_otherView);
 }
 
 SymbolList &SymbolList::operator +=(SymbolList &&i_symbolList)
@@ -292,6 +454,65 @@ SymbolList &SymbolList::operator +=(SymbolList const &i_symbolList)
 
   return *this;
 }
+
+SymbolList &SymbolList::operator =(SymbolList &&i_symbolList)
+{
+  if(this == &i_symbolList)
+  {
+    return *this;
+  }
+  this->clear();
+  m_flags = i_symbolList.m_flags;
+
+  /***** Inline symbols cannot change hands, so they are moved one by one *****/
+  if(i_symbolList.m_symbolArray == i_symbolList.inlineSymbols())
+  {
+    for(size_t i=0; i<i_symbolList.m_symbolCount; ++i)
+    {
+      new (&m_symbolArray[i]) Symbol(std::move(i_symbolList.m_symbolArray[i]));
+    }
+    m_symbolCount = i_symbolList.m_symbolCount;
+    i_symbolList.clear();
+    return *this;
+  }
+
+  /***** Take heap array and remove ownership from other list *****/
+  m_symbolArray = i_symbolList.m_symbolArray;
+  m_symbolCount = i_symbolList.m_symbolCount;
+  m_symbolCapacity = i_symbolList.m_symbolCapacity;
+  i_symbolList.m_flags = SymbolList::Flags::F_DEFAULT;
+  i_symbolList.m_symbolArray = i_symbolList.inlineSymbols();
+  i_symbolList.m_symbolCount = 0;
+  i_symbolList.m_symbolCapacity = INLINE_SYMBOLS;
+
+  return *this;
+}
+
+SymbolList &SymbolList::operator =(SymbolList const &i_symbolList)
+{
+  if(this == &i_symbolList)
+  {
+    return *this;
+  }
+
+  /***** Drop local symbols but keep their room *****/
+  for(size_t i=0; i<m_symbolCount; ++i)
+  {
+    m_symbolArray[i].~Symbol();
+  }
+  m_symbolCount = 0;
+
+  /***** Copy remote array *****/
+  this->reserve(i_symbolList.m_symbolCount);
+  for(size_t i=0; i<i_symbolList.m_symbolCount; ++i)
+  {
+    new (&m_symbolArray[i]) Symbol(i_symbolList.m_symbolArray[i]);
+  }
+  m_symbolCount = i_symbolList.m_symbolCount;
+  m_flags = i_symbolList.m_flags;
+
+  return *this;
+}
 /**************************************************/
 
 /********************----- Operators -----********************/
@@ -7,6 +7,46 @@
 #include <limits>
 #include <vector>
 
+class SymbolList;
+
+/********************----- CLASS: SymbolListView -----********************/
+//A borrowed run of symbols; valid only while the list it points into is
+//neither changed nor destroyed
+class SymbolListView
+{
+public:
+  SymbolListView(SymbolList const &i_symbolList);
+  SymbolListView(Symbol const *i_symbolArray, size_t const i_symbolCount);
+  SymbolListView();
+
+  Symbol const *begin() const;
+  Symbol const *end() const;
+
+  CompareResult compare(SymbolListView const &i_otherView) const;
+  bool containsEpsilon() const;
+  size_t hash() const;
+
+  size_t count() const;
+
+  Symbol const &get(size_t const i_index) const;
+
+  bool isEmpty() const;
+
+  SymbolListView sublist(size_t const i_position, size_t const i_length=std::numeric_limits<size_t>::max()) const;
+
+  std::string toString() const;
+
+  Symbol const &operator [](size_t const i_index) const;
+  bool operator <(SymbolListView const &i_otherView) const;
+  bool operator==(SymbolListView const &i_otherView) const;
+  bool operator!=(SymbolListView const &i_otherView) const;
+  bool operator >(SymbolListView const &i_otherView) const;
+private:
+  Symbol const *m_symbolArray;
+  size_t m_symbolCount;
+};
+/**************************************************/
+
 /********************----- CLASS: SymbolList -----********************/
 class SymbolList
 {
@@ -16,6 +56,7 @@ public:
   SymbolList(SymbolList &&i_symbolList);
   SymbolList(SymbolList const &i_symbolList);
   SymbolList(SymbolList const &i_symbolList, size_t const i_position, size_t const i_length=std::numeric_limits<size_t>::max());
+  explicit SymbolList(SymbolListView const &i_symbolView);
   SymbolList();
   virtual ~SymbolList();
 
@@ -23,39 +64,52 @@ public:
   void append(SymbolList &&i_symbolList);
 
   void clear();
+  void reserve(size_t const i_symbolCount);
 
-  CompareResult compare(SymbolList const &i_otherList) const;
+  CompareResult compare(SymbolListView const &i_otherView) const;
   bool containsEpsilon() const;
+  size_t hash() const;
 
+  size_t capacity() const;
   size_t count() const;
+  Symbol const *data() const;
 
   Symbol const &get(size_t const i_index) const;
 
   bool isEmpty() const;
 
-  SymbolList sublist(size_t const i_position, size_t const i_length=std::numeric_limits<size_t>::max()) const;
+  SymbolListView sublist(size_t const i_position, size_t const i_length=std::numeric_limits<size_t>::max()) const;
 
   std::string toString() const;
 
   Symbol const &operator [](size_t const i_index) const;
-  bool operator <(SymbolList const &i_symbolList) const;
-  bool operator==(SymbolList const &i_symbolList) const;
-  bool operator!=(SymbolList const &i_symbolList) const;
-  bool operator >(SymbolList const &i_symbolList) const;
+  bool operator <(SymbolListView const &i_otherView) const;
+  bool operator==(SymbolListView const &i_otherView) const;
+  bool operator!=(SymbolListView const &i_otherView) const;
+  bool operator >(SymbolListView const &i_otherView) const;
   SymbolList &operator += (SymbolList &&i_symbolList);
   SymbolList &operator += (SymbolList const &i_symbolList);
+  SymbolList &operator =(SymbolList &&i_symbolList);
+  SymbolList &operator =(SymbolList const &i_symbolList);
 private:
-  SymbolList &operator =(SymbolList &&i_symbolList)=delete;
-  SymbolList &operator =(SymbolList const &i_symbolList)=delete;
   enum class Flags
   {
     F_EPSILON=(1<<0),
     F_DEFAULT=0,
   };
 
+  //Lists this long or shorter keep their symbols inline; single symbols
+  //are the usual case for left sides and lookaheads
+  static size_t const INLINE_SYMBOLS=1;
+
+  void grow(size_t const i_symbolCount);
+  Symbol *inlineSymbols();
+
   Flags m_flags;
-  Symbol * m_symbolArray;
-  size_t m_symbolCount;
+  uint32_t m_symbolCount;
+  uint32_t m_symbolCapacity;
+  Symbol * m_symbolArray; //inlineSymbols() or the heap
+  alignas(Symbol) unsigned char m_inlineStorage[INLINE_SYMBOLS*sizeof(Symbol)];
 };
 /**************************************************/
 
@@ -67,7 +121,16 @@ namespace std
   {
     size_t operator ()(SymbolList const &i_symbolList) const
     {
-      return i_symbolList.count();
+      return i_symbolList.hash();
+    }
+  };
+
+  template <>
+  struct hash<SymbolListView>
+  {
+    size_t operator ()(SymbolListView const &i_symbolView) const
+    {
+      return i_symbolView.hash();
     }
   };
 }
@@ -0,0 +1,365 @@
+#include "BenchGrammars.hpp"
+
+#include "Production.hpp"
+#include "Symbol.hpp"
+
+#include <cstring>
+
+/********************----- CLASS: BenchWriter -----********************/
+BenchWriter::BenchWriter(std::ostream &o_output, uint32_t const i_seed)
+:m_output(o_output), m_random(i_seed), m_byteCount(0), m_tokenCount(0)
+{
+}
+
+size_t BenchWriter::byteCount() const
+{
+  return m_byteCount;
+}
+
+size_t BenchWriter::tokenCount() const
+{
+  return m_tokenCount;
+}
+
+void BenchWriter::newline()
+{
+  m_output.put('\n');
+  ++m_byteCount;
+}
+
+size_t BenchWriter::random(size_t const i_limit)
+{
+  return (m_random() % i_limit);
+}
+
+void BenchWriter::token(char const * const i_token)
+{
+  size_t const tokenLength=strlen(i_token);
+  m_output.write(i_token, tokenLength);
+  m_output.put(' ');
+  m_byteCount += tokenLength+1;
+  ++m_tokenCount;
+}
+/**************************************************/
+
+/********************----- CLASS: BenchCase -----********************/
+BenchCase::BenchCase(char const * const i_name, GrammarBuilder const i_grammarBuilder, InputWriter const i_inputWriter, char const * const i_splitToken)
+:m_name(i_name), m_grammarBuilder(i_grammarBuilder), m_inputWriter(i_inputWriter), m_splitToken(i_splitToken)
+{
+}
+
+void BenchCase::buildGrammar(Grammar &o_grammar) const
+{
+  m_grammarBuilder(o_grammar);
+}
+
+std::string const &BenchCase::name() const
+{
+  return m_name;
+}
+
+Symbol BenchCase::splitToken() const
+{
+  return T(m_splitToken.c_str());
+}
+
+void BenchCase::writeInput(BenchWriter &io_writer, size_t const i_targetBytes) const
+{
+  //Inputs are sequences of independent top-level items, so any prefix
+  //ending on an item boundary is valid
+  while(io_writer.byteCount() < i_targetBytes)
+  {
+    m_inputWriter(io_writer);
+    io_writer.newline();
+  }
+}
+/**************************************************/
+
+/********************----- Grammars -----********************/
+std::vector<BenchCase> benchCases()
+{
+  std::vector<BenchCase> cases;
+  cases.push_back(BenchCase("expr", buildExpressionGrammar, writeExpressionInput, ";"));
+  cases.push_back(BenchCase("json", buildJSONGrammar, writeJSONInput, "}"));
+  cases.push_back(BenchCase("stmt", buildStatementGrammar, writeStatementInput, ";"));
+  return cases;
+}
+
+void buildExpressionGrammar(Grammar &o_grammar)
+{
+  Grammar &g=o_grammar;
+  g |= NT("goal") >>= NT("lines");
+  g |= NT("lines") >>= NT("lines") + NT("line");
+  g |= NT("lines") >>= NT("line");
+  g |= NT("line") >>= NT("expr") + T(";");
+  g |= NT("expr") >>= NT("expr") + T("+") + NT("term");
+  g |= NT("expr") >>= NT("expr") + T("-") + NT("term");
+  g |= NT("expr") >>= NT("term");
+  g |= NT("term") >>= NT("term") + T("*") + NT("factor");
+  g |= NT("term") >>= NT("term") + T("/") + NT("factor");
+  g |= NT("term") >>= NT("factor");
+  g |= NT("factor") >>= T("(") + NT("expr") + T(")");
+  g |= NT("factor") >>= T("id");
+  g |= NT("factor") >>= T("num");
+}
+
+void buildJSONGrammar(Grammar &o_grammar)
+{
+  Grammar &g=o_grammar;
+  g |= NT("goal") >>= NT("documents");
+  g |= NT("documents") >>= NT("documents") + NT("object");
+  g |= NT("documents") >>= NT("object");
+  g |= NT("object") >>= T("{") + T("}");
+  g |= NT("object") >>= T("{") + NT("members") + T("}");
+  g |= NT("members") >>= NT("members") + T(",") + NT("pair");
+  g |= NT("members") >>= NT("pair");
+  g |= NT("pair") >>= T("str") + T(":") + NT("value");
+  g |= NT("array") >>= T("[") + T("]");
+  g |= NT("array") >>= T("[") + NT("elements") + T("]");
+  g |= NT("elements") >>= NT("elements") + T(",") + NT("value");
+  g |= NT("elements") >>= NT("value");
+  g |= NT("value") >>= NT("object");
+  g |= NT("value") >>= NT("array");
+  g |= NT("value") >>= T("str");
+  g |= NT("value") >>= T("num");
+  g |= NT("value") >>= T("true");
+  g |= NT("value") >>= T("false");
+  g |= NT("value") >>= T("null");
+}
+
+void buildStatementGrammar(Grammar &o_grammar)
+{
+  Grammar &g=o_grammar;
+  g |= NT("goal") >>= NT("stmts");
+  g |= NT("stmts") >>= NT("stmts") + NT("stmt");
+  g |= NT("stmts") >>= NT("stmt");
+  g |= NT("stmt") >>= T("id") + T("=") + NT("expr") + T(";");
+  g |= NT("stmt") >>= T("id") + T("(") + NT("args") + T(")") + T(";");
+  g |= NT("stmt") >>= T("id") + T("(") + T(")") + T(";");
+  g |= NT("stmt") >>= T("if") + T("(") + NT("expr") + T(")") + NT("block");
+  g |= NT("stmt") >>= T("if") + T("(") + NT("expr") + T(")") + NT("block") + T("else") + NT("block");
+  g |= NT("stmt") >>= T("while") + T("(") + NT("expr") + T(")") + NT("block");
+  g |= NT("stmt") >>= T("return") + NT("expr") + T(";");
+  g |= NT("stmt") >>= NT("block");
+  g |= NT("block") >>= T("{") + NT("stmts") + T("}");
+  g |= NT("block") >>= T("{") + T("}");
+  g |= NT("expr") >>= NT("sum") + T("<") + NT("sum");
+  g |= NT("expr") >>= NT("sum");
+  g |= NT("sum") >>= NT("sum") + T("+") + NT("product");
+  g |= NT("sum") >>= NT("sum") + T("-") + NT("product");
+  g |= NT("sum") >>= NT("product");
+  g |= NT("product") >>= NT("product") + T("*") + NT("unary");
+  g |= NT("product") >>= NT("unary");
+  g |= NT("unary") >>= T("-") + NT("unary");
+  g |= NT("unary") >>= NT("primary");
+  g |= NT("primary") >>= T("id");
+  g |= NT("primary") >>= T("num");
+  g |= NT("primary") >>= T("(") + NT("expr") + T(")");
+  g |= NT("primary") >>= T("id") + T("(") + NT("args") + T(")");
+  g |= NT("primary") >>= T("id") + T("(") + T(")");
+  g |= NT("args") >>= NT("args") + T(",") + NT("expr");
+  g |= NT("args") >>= NT("expr");
+}
+/**************************************************/
+
+/********************----- Input Writers -----********************/
+static void writeExpression(BenchWriter &io_writer, size_t const i_depth)
+{
+  static char const * const sumOperators[]={"+", "-"};
+  static char const * const productOperators[]={"*", "/"};
+
+  size_t const termCount=1+io_writer.random(4);
+  for(size_t t=0; t<termCount; ++t)
+  {
+    if(t > 0)
+    {
+      io_writer.token(sumOperators[io_writer.random(2)]);
+    }
+
+    size_t const factorCount=1+io_writer.random(3);
+    for(size_t f=0; f<factorCount; ++f)
+    {
+      if(f > 0)
+      {
+        io_writer.token(productOperators[io_writer.random(2)]);
+      }
+
+      if(i_depth > 0 && io_writer.random(5) == 0)
+      {
+        io_writer.token("(");
+        writeExpression(io_writer, i_depth-1);
+        io_writer.token(")");
+      }
+      else
+      {
+        io_writer.token(io_writer.random(2) ? "id" : "num");
+      }
+    }
+  }
+}
+
+void writeExpressionInput(BenchWriter &io_writer)
+{
+  writeExpression(io_writer, 4);
+  io_writer.token(";");
+}
+
+static void writeJSONValue(BenchWriter &io_writer, size_t const i_depth);
+
+static void writeJSONObject(BenchWriter &io_writer, size_t const i_depth)
+{
+  io_writer.token("{");
+  size_t const memberCount=io_writer.random(6);
+  for(size_t m=0; m<memberCount; ++m)
+  {
+    if(m > 0)
+    {
+      io_writer.token(",");
+    }
+    io_writer.token("str");
+    io_writer.token(":");
+    writeJSONValue(io_writer, i_depth);
+  }
+  io_writer.token("}");
+}
+
+static void writeJSONValue(BenchWriter &io_writer, size_t const i_depth)
+{
+  static char const * const scalars[]={"str", "num", "true", "false", "null"};
+
+  size_t const choice=(i_depth > 0 ? io_writer.random(8) : 7);
+  if(choice == 0)
+  {
+    writeJSONObject(io_writer, i_depth-1);
+  }
+  else if(choice == 1)
+  {
+    io_writer.token("[");
+    size_t const elementCount=io_writer.random(5);
+    for(size_t e=0; e<elementCount; ++e)
+    {
+      if(e > 0)
+      {
+        io_writer.token(",");
+      }
+      writeJSONValue(io_writer, i_depth-1);
+    }
+    io_writer.token("]");
+  }
+  else
+  {
+    io_writer.token(scalars[io_writer.random(5)]);
+  }
+}
+
+void writeJSONInput(BenchWriter &io_writer)
+{
+  writeJSONObject(io_writer, 3);
+}
+
+static void writeStatementExpression(BenchWriter &io_writer, size_t const i_depth)
+{
+  static char const * const operators[]={"+", "-", "*", "<"};
+
+  size_t const operandCount=1+io_writer.random(3);
+  for(size_t o=0; o<operandCount; ++o)
+  {
+    if(o > 0)
+    {
+      //Comparisons do not chain in this grammar
+      io_writer.token(operators[io_writer.random(o == 1 ? 4 : 3)]);
+    }
+
+    size_t const choice=(i_depth > 0 ? io_writer.random(8) : 7);
+    if(choice == 0)
+    {
+      io_writer.token("(");
+      writeStatementExpression(io_writer, i_depth-1);
+      io_writer.token(")");
+    }
+    else if(choice == 1)
+    {
+      io_writer.token("id");
+      io_writer.token("(");
+      io_writer.token("num");
+      io_writer.token(",");
+      writeStatementExpression(io_writer, i_depth-1);
+      io_writer.token(")");
+    }
+    else if(choice == 2)
+    {
+      io_writer.token("-");
+      io_writer.token("id");
+    }
+    else
+    {
+      io_writer.token(io_writer.random(2) ? "id" : "num");
+    }
+  }
+}
+
+static void writeStatement(BenchWriter &io_writer, size_t const i_depth);
+
+static void writeBlock(BenchWriter &io_writer, size_t const i_depth)
+{
+  io_writer.token("{");
+  size_t const statementCount=(i_depth > 0 ? io_writer.random(4) : 0);
+  for(size_t s=0; s<statementCount; ++s)
+  {
+    writeStatement(io_writer, i_depth-1);
+  }
+  io_writer.token("}");
+}
+
+static void writeStatement(BenchWriter &io_writer, size_t const i_depth)
+{
+  switch(io_writer.random(i_depth > 0 ? 6 : 3))
+  {
+    case 0:
+      io_writer.token("id");
+      io_writer.token("=");
+      writeStatementExpression(io_writer, 2);
+      io_writer.token(";");
+      break;
+    case 1:
+      io_writer.token("id");
+      io_writer.token("(");
+      writeStatementExpression(io_writer, 1);
+      io_writer.token(")");
+      io_writer.token(";");
+      break;
+    case 2:
+      io_writer.token("return");
+      writeStatementExpression(io_writer, 2);
+      io_writer.token(";");
+      break;
+    case 3:
+      io_writer.token("if");
+      io_writer.token("(");
+      writeStatementExpression(io_writer, 1);
+      io_writer.token(")");
+      writeBlock(io_writer, i_depth);
+      if(io_writer.random(2))
+      {
+        io_writer.token("else");
+        writeBlock(io_writer, i_depth);
+      }
+      break;
+    case 4:
+      io_writer.token("while");
+      io_writer.token("(");
+      writeStatementExpression(io_writer, 1);
+      io_writer.token(")");
+      writeBlock(io_writer, i_depth);
+      break;
+    default:
+      writeBlock(io_writer, i_depth);
+      break;
+  }
+}
+
+void writeStatementInput(BenchWriter &io_writer)
+{
+  writeStatement(io_writer, 3);
+}
+/**************************************************/
@@ -0,0 +1,64 @@
+#ifndef _BENCHGRAMMARS_HPP_
+#define _BENCHGRAMMARS_HPP_
+
+#include "Grammar.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <random>
+
+/********************----- CLASS: BenchWriter -----********************/
+//Writes whitespace separated tokens in the form LexText reads back
+class BenchWriter
+{
+public:
+  BenchWriter(std::ostream &o_output, uint32_t const i_seed);
+
+  size_t byteCount() const;
+  size_t tokenCount() const;
+
+  void newline();
+  size_t random(size_t const i_limit);
+  void token(char const * const i_token);
+private:
+  std::ostream &m_output;
+  std::mt19937 m_random;
+  size_t m_byteCount;
+  size_t m_tokenCount;
+};
+/**************************************************/
+
+/********************----- CLASS: BenchCase -----********************/
+class BenchCase
+{
+public:
+  typedef void (*GrammarBuilder)(Grammar &o_grammar);
+  typedef void (*InputWriter)(BenchWriter &io_writer);
+
+  BenchCase(char const * const i_name, GrammarBuilder const i_grammarBuilder, InputWriter const i_inputWriter, char const * const i_splitToken);
+
+  void buildGrammar(Grammar &o_grammar) const;
+  std::string const &name() const;
+  Symbol splitToken() const;
+  void writeInput(BenchWriter &io_writer, size_t const i_targetBytes) const;
+private:
+  std::string m_name;
+  GrammarBuilder m_grammarBuilder;
+  InputWriter m_inputWriter;
+  std::string m_splitToken; //Ends a top-level item, see LRParser::addSplitToken()
+};
+/**************************************************/
+
+/********************----- Helpers -----********************/
+std::vector<BenchCase> benchCases();
+
+void buildExpressionGrammar(Grammar &o_grammar);
+void buildJSONGrammar(Grammar &o_grammar);
+void buildStatementGrammar(Grammar &o_grammar);
+
+void writeExpressionInput(BenchWriter &io_writer);
+void writeJSONInput(BenchWriter &io_writer);
+void writeStatementInput(BenchWriter &io_writer);
+/**************************************************/
+
+#endif /* _BENCHGRAMMARS_HPP_ */
@@ -0,0 +1,251 @@
+#include "BenchGrammars.hpp"
+
+#include "CompiledGrammar.hpp"
+#include "Grammar.hpp"
+#include "LRParser.hpp"
+#include "LexText.hpp"
+#include "LRStats.hpp"
+#include "ParseSession.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+/********************----- Helpers -----********************/
+//Each measurement is printed as one JSON object per line, so runs can be
+//collected with e.g. "make bench > before.jsonl" and compared with any JSON tool
+
+//Quotes a string for a JSON field, escaping quotes, backslashes and control characters
+static std::string jsonString(std::string const &i_string)
+{
+  std::string outputString="\"";
+  for(char const c : i_string)
+  {
+    if(c == '"' || c == '\\')
+    {
+      outputString += '\\';
+      outputString += c;
+    }
+    else if(static_cast<unsigned char>(c) < 0x20)
+    {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(c)));
+      outputString += escaped;
+    }
+    else
+    {
+      outputString += c;
+    }
+  }
+  outputString += '"';
+
+  return outputString;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point const &i_start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-i_start).count();
+}
+
+static std::vector<size_t> parseSizes(char const * const i_sizes)
+{
+  std::vector<size_t> sizes;
+  std::stringstream sizeStream(i_sizes);
+  std::string size;
+  while(std::getline(sizeStream, size, ','))
+  {
+    sizes.push_back(strtoull(size.c_str(), nullptr, 10));
+  }
+
+  return sizes;
+}
+
+static void usage(char const * const i_name)
+{
+  std::cerr << "Usage: " << i_name << " [--grammar NAME] [--sizes BYTES[,BYTES...]] [--repeat N] [--directory DIR] [--unit-rules MODE] [--type TYPE] [--tree] [--threads N]" << std::endl;
+  std::cerr << "  grammars: expr json stmt (default: all)" << std::endl;
+  std::cerr << "  sizes:    generated input sizes in bytes (default: 65536,1048576,16777216)" << std::endl;
+  std::cerr << "  repeat:   parse runs per input, the fastest is reported (default: 3)" << std::endl;
+  std::cerr << "  directory: where generated inputs are written (default: /tmp)" << std::endl;
+  std::cerr << "  unit-rules: keep, bypass or report unit reductions (default: keep)" << std::endl;
+  std::cerr << "  type:     table type, LR, LALR, SLR or LR0 (default: LR)" << std::endl;
+  std::cerr << "  tree:     build a ParseTree while parsing" << std::endl;
+  std::cerr << "  threads:  parse each input split across N threads (default: 1)" << std::endl;
+}
+/**************************************************/
+
+int main(int const argc, char const * const * const argv)
+{
+  std::string grammarName;
+  std::vector<size_t> sizes={65536, 1048576, 16777216};
+  size_t repeat=3;
+  std::string directory="/tmp";
+  std::string unitRulesName="keep";
+  LRParser::UnitRules unitRules=LRParser::UnitRules::KEEP;
+  std::string typeName="LR";
+  LRTable::Type type=LRTable::Type::LR;
+  bool buildTree=false;
+  size_t threadCount=1;
+
+  /***** Arguments *****/
+  for(int i=1; i<argc; ++i)
+  {
+    if(strcmp(argv[i], "--grammar") == 0 && i+1 < argc)
+    {
+      grammarName = argv[++i];
+    }
+    else if(strcmp(argv[i], "--sizes") == 0 && i+1 < argc)
+    {
+      sizes = parseSizes(argv[++i]);
+    }
+    else if(strcmp(argv[i], "--repeat") == 0 && i+1 < argc)
+    {
+      repeat = std::max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+    }
+    else if(strcmp(argv[i], "--directory") == 0 && i+1 < argc)
+    {
+      directory = argv[++i];
+    }
+    else if(strcmp(argv[i], "--unit-rules") == 0 && i+1 < argc && (strcmp(argv[i+1], "keep") == 0 || strcmp(argv[i+1], "bypass") == 0 || strcmp(argv[i+1], "report") == 0))
+    {
+      unitRulesName = argv[++i];
+      unitRules = (unitRulesName == "keep") ? LRParser::UnitRules::KEEP : ((unitRulesName == "bypass") ? LRParser::UnitRules::BYPASS : LRParser::UnitRules::REPORT);
+    }
+    else if(strcmp(argv[i], "--tree") == 0)
+    {
+      buildTree = true;
+    }
+    else if(strcmp(argv[i], "--threads") == 0 && i+1 < argc)
+    {
+      threadCount = std::max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+    }
+    else if(strcmp(argv[i], "--type") == 0 && i+1 < argc && (strcmp(argv[i+1], "LR") == 0 || strcmp(argv[i+1], "LALR") == 0 || strcmp(argv[i+1], "SLR") == 0 || strcmp(argv[i+1], "LR0") == 0))
+    {
+      typeName = argv[++i];
+      type = (typeName == "LR") ? LRTable::Type::LR : ((typeName == "LALR") ? LRTable::Type::LALR : ((typeName == "SLR") ? LRTable::Type::SLR : LRTable::Type::LR0));
+    }
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  for(BenchCase const &benchCase : benchCases())
+  {
+    if(!grammarName.empty() && grammarName != benchCase.name())
+    {
+      continue;
+    }
+
+    /***** Table construction *****/
+    Grammar g;
+    benchCase.buildGrammar(g);
+
+    //The table is built from the frozen grammar, whose analysis fills the
+    //FIRST and FOLLOW phases. A grammar outside the table type's class is
+    //reported and skipped; the full list of conflicts goes to stderr
+    LRStats buildStats;
+    std::chrono::steady_clock::time_point const buildStart=std::chrono::steady_clock::now();
+    std::unique_ptr<CompiledGrammar const> compiledPointer;
+    std::unique_ptr<LRParser> parserPointer;
+    try
+    {
+      compiledPointer.reset(new CompiledGrammar(g.freeze(&buildStats)));
+      parserPointer.reset(new LRParser(type, 1, *compiledPointer, &buildStats));
+    }
+    catch(std::logic_error const &e)
+    {
+      std::string const message=e.what();
+      std::cerr << benchCase.name() << ": " << message << std::endl;
+      std::cout << "{\"grammar\":" << jsonString(benchCase.name()) << ",\"phase\":\"build\",\"type\":" << jsonString(typeName)
+        << ",\"error\":" << jsonString(message.substr(0, message.find('\n'))) << "}" << std::endl;
+      continue;
+    }
+    double const buildSeconds=secondsSince(buildStart);
+    LRParser &parser=*parserPointer;
+    parser.setUnitRules(unitRules);
+    parser.addSplitToken(benchCase.splitToken());
+
+    std::shared_ptr<LRTable const> const table=parser.table();
+    std::cout << "{\"grammar\":" << jsonString(benchCase.name()) << ",\"phase\":\"build\",\"type\":" << jsonString(typeName)
+      << ",\"productions\":" << g.productionCount()
+      << ",\"states\":" << table->stateCount()
+      << ",\"cores\":" << table->coreCount()
+      << ",\"items\":" << table->itemCount()
+      << ",\"table_bytes\":" << table->sizeBytes()
+      << ",\"compressed_bytes\":" << table->compressedSizeBytes()
+      << ",\"seconds\":" << buildSeconds
+      << ",\"stats\":" << buildStats.toJSON() << "}" << std::endl;
+
+    /***** Parsing *****/
+    ParseSession session;
+    ParseTree tree;
+    session.setTree(buildTree ? &tree : nullptr);
+    session.setCounting(true);
+    for(size_t const targetBytes : sizes)
+    {
+      std::string const inputPath=directory+"/lr_bench_"+benchCase.name()+"_"+std::to_string(targetBytes)+".txt";
+
+      size_t inputBytes=0;
+      size_t inputTokens=0;
+      {
+        std::ofstream input(inputPath.c_str(), std::ios::binary|std::ios::trunc);
+        BenchWriter writer(input, 1);
+        benchCase.writeInput(writer, targetBytes);
+        inputBytes = writer.byteCount();
+        inputTokens = writer.tokenCount();
+      }
+
+      bool accepted=true;
+      double bestSeconds=0;
+      size_t maxDepth=0;
+      for(size_t run=0; run<repeat; ++run)
+      {
+        std::chrono::steady_clock::time_point const parseStart=std::chrono::steady_clock::now();
+        if(threadCount > 1)
+        {
+          //Chunked lexing is timed too, it is part of getting through the file
+          LexText lex(inputPath, threadCount);
+          SymbolStack const &tokens=lex.tokens();
+          accepted = parser.parseParallel(tokens.data(), tokens.size(), session, threadCount) && accepted;
+        }
+        else
+        {
+          LexText lex(inputPath);
+          accepted = parser.parse(lex, session) && accepted;
+        }
+        double const parseSeconds=secondsSince(parseStart);
+        maxDepth = std::max(maxDepth, session.maxDepth());
+        if(run == 0 || parseSeconds < bestSeconds)
+        {
+          bestSeconds = parseSeconds;
+        }
+      }
+      std::remove(inputPath.c_str());
+
+      std::cout << "{\"grammar\":" << jsonString(benchCase.name()) << ",\"phase\":\"parse\""
+        << ",\"unit_rules\":" << jsonString(unitRulesName)
+        << ",\"threads\":" << threadCount
+        << ",\"input_bytes\":" << inputBytes
+        << ",\"tokens\":" << inputTokens
+        << ",\"accepted\":" << (accepted ? "true" : "false")
+        << ",\"runs\":" << repeat
+        << ",\"shifts\":" << session.shiftCount()
+        << ",\"reduces\":" << session.reduceCount()
+        << ",\"max_depth\":" << maxDepth
+        << ",\"tree_nodes\":" << tree.size()
+        << ",\"seconds\":" << bestSeconds
+        << ",\"tokens_per_second\":" << (inputTokens/bestSeconds)
+        << ",\"mb_per_second\":" << (inputBytes/bestSeconds/1048576.0) << "}" << std::endl;
+    }
+  }
+
+  return 0;
+}
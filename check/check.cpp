@@ -0,0 +1,597 @@
+#include "BenchGrammars.hpp"
+
+#include "Grammar.hpp"
+#include "LRParser.hpp"
+#include "LexText.hpp"
+#include "ParseSession.hpp"
+#include "ParseTree.hpp"
+#include "Production.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/********************----- Helpers -----********************/
+//Each check compares two ways of getting the same parse and prints one line
+//per grammar; the exit status is non-zero if any of them differ
+
+//A parser step as handlers see it; shifts use ParseTree::TOKEN and their position
+struct CheckStep
+{
+  uint32_t production;
+  size_t begin;
+  size_t end;
+
+  bool operator ==(CheckStep const &i_step) const
+  {
+    return (production == i_step.production && begin == i_step.begin && end == i_step.end);
+  }
+};
+
+struct CheckRecorder
+{
+  std::vector<CheckStep> &steps;
+  void shift(Symbol const &, size_t const i_position){ steps.push_back(CheckStep{ParseTree::TOKEN, i_position, i_position}); }
+  void reduce(uint32_t const i_production, size_t const i_tokenBegin, size_t const i_tokenEnd){ steps.push_back(CheckStep{i_production, i_tokenBegin, i_tokenEnd}); }
+};
+
+//What a parse left in its session, and the steps it took
+struct CheckRun
+{
+  ParseSession::Status status;
+  size_t shiftCount;
+  size_t reduceCount;
+  LRParseErrorVector errors;
+  std::vector<CheckStep> steps;
+};
+
+//Ways a token is broken to make a syntax error
+enum class CheckEdit
+{
+  DELETE,
+  REPEAT,
+  SWAP,
+};
+
+class CheckLex : public Lex
+{
+public:
+  CheckLex(SymbolStack const &i_tokens)
+  :m_tokens(i_tokens), m_next(0)
+  {
+  }
+
+  virtual Symbol pop() override
+  {
+    return (m_next < m_tokens.size()) ? m_tokens[m_next++] : END();
+  }
+private:
+  SymbolStack const &m_tokens;
+  size_t m_next;
+};
+
+static size_t s_checkCount=0;
+static size_t s_failureCount=0;
+
+static void report(char const * const i_check, std::string const &i_grammarName, bool const i_ok, std::string const &i_detail=std::string())
+{
+  ++s_checkCount;
+  s_failureCount += i_ok ? 0 : 1;
+  std::cout << i_check << " " << i_grammarName << ": " << (i_ok ? "ok" : "FAILED") << (i_detail.empty() ? "" : " ("+i_detail+")") << std::endl;
+}
+
+//Errors are compared without their state, which differs between tables
+//that accept the same language
+static std::string errorKey(LRParseError const &i_error)
+{
+  return std::to_string(i_error.position()) + " " + i_error.token().toString() + " " + std::to_string(static_cast<int>(i_error.repair()))
+    + " " + i_error.repairToken().toString() + " " + std::to_string(i_error.skipCount());
+}
+
+static void readSession(ParseSession const &i_session, CheckRun &io_run)
+{
+  io_run.status = i_session.status();
+  io_run.shiftCount = i_session.shiftCount();
+  io_run.reduceCount = i_session.reduceCount();
+  for(LRParseError const &error : i_session.errors())
+  {
+    io_run.errors.push_back(error);
+  }
+}
+
+static CheckRun parseTokens(LRParser const &i_parser, SymbolStack const &i_tokens)
+{
+  CheckRun run;
+  CheckRecorder recorder{run.steps};
+  ParseSession session;
+  session.setCounting(true);
+  CheckLex lex(i_tokens);
+  i_parser.parse(lex, session, recorder);
+  readSession(session, run);
+
+  return run;
+}
+
+//Pushes a token at a time, or slices of i_sliceSize tokens
+static CheckRun pushTokens(LRParser const &i_parser, SymbolStack const &i_tokens, size_t const i_sliceSize)
+{
+  CheckRun run;
+  CheckRecorder recorder{run.steps};
+  ParseSession session;
+  session.setCounting(true);
+  for(size_t i=0; i<i_tokens.size() && session.status() == ParseSession::Status::NEED_MORE; i+=i_sliceSize)
+  {
+    if(i_sliceSize == 1)
+    {
+      i_parser.push(session, Symbol(i_tokens[i]), recorder);
+    }
+    else
+    {
+      i_parser.push(session, i_tokens.data()+i, std::min(i_sliceSize, i_tokens.size()-i), recorder);
+    }
+  }
+  readSession(session, run);
+
+  return run;
+}
+
+//Without a handler the chunks log no steps, so only the outcome is kept
+static CheckRun parallelTokens(LRParser const &i_parser, SymbolStack const &i_tokens, size_t const i_threadCount, bool const i_record)
+{
+  CheckRun run;
+  ParseSession session;
+  session.setCounting(true);
+  if(i_record)
+  {
+    CheckRecorder recorder{run.steps};
+    i_parser.parseParallel(i_tokens.data(), i_tokens.size(), session, i_threadCount, recorder);
+  }
+  else
+  {
+    i_parser.parseParallel(i_tokens.data(), i_tokens.size(), session, i_threadCount);
+  }
+  readSession(session, run);
+
+  return run;
+}
+
+//Describes the first difference between two runs, or returns an empty string
+static std::string compareRuns(CheckRun const &i_expected, CheckRun const &i_actual)
+{
+  if(i_expected.status != i_actual.status)
+  {
+    return "status "+std::to_string(static_cast<int>(i_expected.status))+" != "+std::to_string(static_cast<int>(i_actual.status));
+  }
+  if(i_expected.shiftCount != i_actual.shiftCount || i_expected.reduceCount != i_actual.reduceCount)
+  {
+    return "counts "+std::to_string(i_expected.shiftCount)+"/"+std::to_string(i_expected.reduceCount)+" != "+std::to_string(i_actual.shiftCount)+"/"+std::to_string(i_actual.reduceCount);
+  }
+  if(i_expected.errors.size() != i_actual.errors.size())
+  {
+    return "error counts "+std::to_string(i_expected.errors.size())+" != "+std::to_string(i_actual.errors.size());
+  }
+  for(size_t i=0; i<i_expected.errors.size(); ++i)
+  {
+    if(errorKey(i_expected.errors[i]) != errorKey(i_actual.errors[i]))
+    {
+      return "error "+std::to_string(i)+": "+i_expected.errors[i].toString()+" != "+i_actual.errors[i].toString();
+    }
+  }
+  for(size_t i=0; i<std::min(i_expected.steps.size(), i_actual.steps.size()); ++i)
+  {
+    if(!(i_expected.steps[i] == i_actual.steps[i]))
+    {
+      return "step "+std::to_string(i)+" differs";
+    }
+  }
+  if(i_expected.steps.size() != i_actual.steps.size())
+  {
+    return "step counts "+std::to_string(i_expected.steps.size())+" != "+std::to_string(i_actual.steps.size());
+  }
+
+  return std::string();
+}
+
+//i_position must leave END, the last token, where it is
+static SymbolStack editTokens(SymbolStack const &i_tokens, size_t const i_position, CheckEdit const i_edit)
+{
+  SymbolStack tokens;
+  for(size_t i=0; i<i_tokens.size(); ++i)
+  {
+    if(i == i_position && i_edit == CheckEdit::DELETE)
+    {
+      continue;
+    }
+    else if(i == i_position && i_edit == CheckEdit::REPEAT)
+    {
+      tokens.push_back(i_tokens[i]);
+    }
+    else if(i == i_position && i_edit == CheckEdit::SWAP)
+    {
+      tokens.push_back(i_tokens[i+1]);
+      tokens.push_back(i_tokens[i]);
+      ++i;
+      continue;
+    }
+    tokens.push_back(i_tokens[i]);
+  }
+
+  return tokens;
+}
+
+//The input REPAIR recovery parsed: what it inserted goes before the token
+//it was unexpected at, and deleted tokens are dropped
+static SymbolStack applyRepairs(SymbolStack const &i_tokens, LRParseErrorVector const &i_errors)
+{
+  SymbolStack tokens;
+  size_t e=0;
+  for(size_t i=0; i<i_tokens.size(); ++i)
+  {
+    bool deleted=false;
+    for(; e<i_errors.size() && i_errors[e].position() == i; ++e)
+    {
+      if(i_errors[e].repair() == LRParseError::Repair::INSERT)
+      {
+        tokens.push_back(i_errors[e].repairToken());
+      }
+      deleted = deleted || (i_errors[e].repair() == LRParseError::Repair::DELETE);
+    }
+    if(!deleted)
+    {
+      tokens.push_back(i_tokens[i]);
+    }
+  }
+
+  return tokens;
+}
+
+static SymbolStack writeTokens(BenchCase const &i_benchCase, std::string const &i_directory, size_t const i_targetBytes)
+{
+  std::string const inputPath=i_directory+"/lr_check_"+i_benchCase.name()+".txt";
+  {
+    std::ofstream input(inputPath.c_str(), std::ios::binary|std::ios::trunc);
+    BenchWriter writer(input, 1);
+    i_benchCase.writeInput(writer, i_targetBytes);
+  }
+
+  //Symbol cannot be assigned, so the tokens are copied out whole
+  SymbolStack tokens(LexText(inputPath, 1).tokens());
+  std::remove(inputPath.c_str());
+
+  return tokens;
+}
+
+static void usage(char const * const i_name)
+{
+  std::cerr << "Usage: " << i_name << " [--directory DIR]" << std::endl;
+  std::cerr << "  directory: where generated inputs are written (default: /tmp)" << std::endl;
+}
+/**************************************************/
+
+/********************----- Checks -----********************/
+//Tables grown one appended production at a time by update() must parse as
+//a table built from scratch does, at every step along the way
+static void checkUpdate(BenchCase const &i_benchCase, SymbolStack const &i_tokens)
+{
+  Grammar g;
+  i_benchCase.buildGrammar(g);
+
+  Grammar grown;
+  size_t const firstCount=g.productionCount()/2;
+  for(size_t i=0; i<firstCount; ++i)
+  {
+    grown |= Production(SymbolList(g[i].left()), SymbolList(g[i].right()));
+  }
+  LRParser updated(LRTable::Type::LR, 1, grown);
+
+  std::string detail;
+  for(size_t i=firstCount; i<g.productionCount() && detail.empty(); ++i)
+  {
+    grown |= Production(SymbolList(g[i].left()), SymbolList(g[i].right()));
+    updated.update(grown);
+
+    LRParser rebuilt(LRTable::Type::LR, 1, grown);
+    detail = compareRuns(parseTokens(rebuilt, i_tokens), parseTokens(updated, i_tokens));
+    if(!detail.empty())
+    {
+      detail = std::to_string(i+1)+" productions: "+detail;
+    }
+  }
+
+  report("update", i_benchCase.name(), detail.empty(), detail);
+}
+
+//Any other change to the grammar makes update() rebuild the table, which
+//must then parse as a table built from scratch does: fewer productions, as
+//normalize() leaves, the same number with the rules in another order, and
+//no change at all
+static void checkRebuild(BenchCase const &i_benchCase, SymbolStack const &i_tokens)
+{
+  Grammar full;
+  i_benchCase.buildGrammar(full);
+
+  //normalize() drops the unreachable production, and every later one moves up
+  Grammar g;
+  for(size_t i=0; i<full.productionCount(); ++i)
+  {
+    g |= Production(SymbolList(full[i].left()), SymbolList(full[i].right()));
+    if(i == 0)
+    {
+      g |= NT("unreachable") >>= i_benchCase.splitToken();
+    }
+  }
+  LRParser updated(LRTable::Type::LR, 1, g);
+  g.normalize();
+  updated.update(g);
+
+  std::string detail;
+  {
+    LRParser rebuilt(LRTable::Type::LR, 1, g);
+    detail = compareRuns(parseTokens(rebuilt, i_tokens), parseTokens(updated, i_tokens));
+    if(!detail.empty())
+    {
+      detail = "normalized: "+detail;
+    }
+  }
+
+  //The start production stays first; the last two trade places
+  Grammar reordered;
+  reordered |= Production(SymbolList(g[0].left()), SymbolList(g[0].right()));
+  size_t const lastIndex=g.productionCount()-1;
+  for(size_t i=1; i<g.productionCount(); ++i)
+  {
+    size_t const index=(i+1 < lastIndex) ? i : ((i == lastIndex) ? i-1 : i+1);
+    reordered |= Production(SymbolList(g[index].left()), SymbolList(g[index].right()));
+  }
+  for(size_t pass=0; pass<2 && detail.empty(); ++pass)
+  {
+    updated.update(reordered);
+    LRParser rebuilt(LRTable::Type::LR, 1, reordered);
+    detail = compareRuns(parseTokens(rebuilt, i_tokens), parseTokens(updated, i_tokens));
+    if(!detail.empty())
+    {
+      detail = std::string(pass == 0 ? "reordered: " : "unchanged: ")+detail;
+    }
+  }
+
+  report("rebuild", i_benchCase.name(), detail.empty(), detail);
+}
+
+//Only precedence changes between these grammars, which settles their
+//conflicts the other way; update() must rebuild rather than keep the table
+static void checkPrecedence()
+{
+  Grammar additive;
+  Grammar multiplicative;
+  for(Grammar *g : {&additive, &multiplicative})
+  {
+    *g |= NT("goal") >>= NT("lines");
+    *g |= NT("lines") >>= NT("lines") + NT("line");
+    *g |= NT("lines") >>= NT("line");
+    *g |= NT("line") >>= NT("expr") + T(";");
+    *g |= NT("expr") >>= NT("expr") + T("+") + NT("expr");
+    *g |= NT("expr") >>= NT("expr") + T("*") + NT("expr");
+    *g |= NT("expr") >>= T("id");
+  }
+  //Later declarations bind tighter
+  additive.addPrecedence(Grammar::Associativity::LEFT, SymbolList(T("*")));
+  additive.addPrecedence(Grammar::Associativity::LEFT, SymbolList(T("+")));
+  multiplicative.addPrecedence(Grammar::Associativity::LEFT, SymbolList(T("+")));
+  multiplicative.addPrecedence(Grammar::Associativity::LEFT, SymbolList(T("*")));
+
+  SymbolStack tokens;
+  for(size_t i=0; i<8; ++i)
+  {
+    for(char const * const token : {"id", "+", "id", "*", "id", "+", "id", ";"})
+    {
+      tokens.push_back(T(token));
+    }
+  }
+  tokens.push_back(END());
+
+  LRParser updated(LRTable::Type::LR, 1, additive);
+  updated.update(multiplicative);
+  LRParser rebuilt(LRTable::Type::LR, 1, multiplicative);
+  std::string const detail=compareRuns(parseTokens(rebuilt, tokens), parseTokens(updated, tokens));
+
+  report("precedence", "expr", detail.empty(), detail);
+}
+
+//Recovery leaves clean input alone, and on broken input first stops where a
+//parse without it does. PANIC must reach the end of the input, resuming
+//only at sync tokens; what REPAIR accepts must be the input with its
+//repairs applied, with the same shift and reduce counts
+static void checkRecovery(BenchCase const &i_benchCase, SymbolStack const &i_tokens)
+{
+  Grammar g;
+  i_benchCase.buildGrammar(g);
+  LRParser plain(LRTable::Type::LR, 1, g);
+  LRParser panic(LRTable::Type::LR, 1, g);
+  panic.setRecovery(LRParser::Recovery::PANIC);
+  panic.addSyncToken(i_benchCase.splitToken());
+  LRParser repair(LRTable::Type::LR, 1, g);
+  repair.setRecovery(LRParser::Recovery::REPAIR);
+
+  CheckRun const cleanRun=parseTokens(plain, i_tokens);
+  std::string detail=compareRuns(cleanRun, parseTokens(panic, i_tokens));
+  if(detail.empty())
+  {
+    detail = compareRuns(cleanRun, parseTokens(repair, i_tokens));
+  }
+
+  /***** A few of each edit, spread over the input *****/
+  static size_t const EDIT_POSITIONS=8;
+  size_t repairedCount=0;
+  for(size_t p=1; p<=EDIT_POSITIONS && detail.empty(); ++p)
+  {
+    for(CheckEdit const edit : {CheckEdit::DELETE, CheckEdit::REPEAT, CheckEdit::SWAP})
+    {
+      size_t const position=p*(i_tokens.size()-2)/(EDIT_POSITIONS+1);
+      SymbolStack const editedTokens=editTokens(i_tokens, position, edit);
+      CheckRun const plainRun=parseTokens(plain, editedTokens);
+      if(plainRun.errors.empty())
+      {
+        continue;
+      }
+      std::string const where="edit "+std::to_string(static_cast<int>(edit))+" at "+std::to_string(position)+": ";
+
+      CheckRun const panicRun=parseTokens(panic, editedTokens);
+      if(panicRun.status == ParseSession::Status::NEED_MORE || panicRun.errors.empty() || panicRun.errors[0].position() != plainRun.errors[0].position())
+      {
+        detail = where+"PANIC stopped at "+(panicRun.errors.empty() ? std::string("no error") : panicRun.errors[0].toString());
+        break;
+      }
+      for(LRParseError const &error : panicRun.errors)
+      {
+        if(error.repair() == LRParseError::Repair::SYNCHRONIZE && !(error.repairToken() == i_benchCase.splitToken() || error.repairToken().isEND()))
+        {
+          detail = where+"PANIC resumed at "+error.toString();
+        }
+      }
+
+      CheckRun const repairRun=parseTokens(repair, editedTokens);
+      if(repairRun.errors.empty() || repairRun.errors[0].position() != plainRun.errors[0].position())
+      {
+        detail = where+"REPAIR stopped at "+(repairRun.errors.empty() ? std::string("no error") : repairRun.errors[0].toString());
+        break;
+      }
+      if(repairRun.status == ParseSession::Status::ACCEPTED)
+      {
+        ++repairedCount;
+        CheckRun const repairedRun=parseTokens(plain, applyRepairs(editedTokens, repairRun.errors));
+        if(repairedRun.status != ParseSession::Status::ACCEPTED || repairedRun.shiftCount != repairRun.shiftCount || repairedRun.reduceCount != repairRun.reduceCount)
+        {
+          detail = where+"REPAIR accepted what its repairs do not";
+          break;
+        }
+      }
+    }
+  }
+  if(detail.empty() && repairedCount == 0)
+  {
+    detail = "REPAIR accepted no edited input";
+  }
+
+  report("recovery", i_benchCase.name(), detail.empty(), detail);
+}
+
+//Pushing the input a token at a time, or in slices, must parse it as
+//parse() does, with or without recovery, and on broken input too
+static void checkPush(BenchCase const &i_benchCase, SymbolStack const &i_tokens)
+{
+  Grammar g;
+  i_benchCase.buildGrammar(g);
+  LRParser parser(LRTable::Type::LR, 1, g);
+  parser.addSyncToken(i_benchCase.splitToken());
+
+  std::vector<SymbolStack> inputs;
+  inputs.push_back(i_tokens);
+  inputs.push_back(editTokens(i_tokens, i_tokens.size()/3, CheckEdit::DELETE));
+  inputs.push_back(editTokens(i_tokens, i_tokens.size()/2, CheckEdit::SWAP));
+
+  std::string detail;
+  for(LRParser::Recovery const recovery : {LRParser::Recovery::NONE, LRParser::Recovery::PANIC, LRParser::Recovery::REPAIR})
+  {
+    parser.setRecovery(recovery);
+    for(size_t i=0; i<inputs.size() && detail.empty(); ++i)
+    {
+      CheckRun const parseRun=parseTokens(parser, inputs[i]);
+      for(size_t const sliceSize : {1, 7})
+      {
+        detail = compareRuns(parseRun, pushTokens(parser, inputs[i], sliceSize));
+        if(!detail.empty())
+        {
+          detail = "recovery "+std::to_string(static_cast<int>(recovery))+", input "+std::to_string(i)+", slices of "+std::to_string(sliceSize)+": "+detail;
+          break;
+        }
+      }
+    }
+  }
+
+  report("push", i_benchCase.name(), detail.empty(), detail);
+}
+
+//Parsing split across threads must give what parse() gives, whether or
+//not steps are recorded, for each table type and unit rule mode the
+//chunks can run with, and on broken input too
+static void checkParallel(BenchCase const &i_benchCase, SymbolStack const &i_tokens)
+{
+  Grammar g;
+  i_benchCase.buildGrammar(g);
+
+  std::vector<SymbolStack> inputs;
+  inputs.push_back(i_tokens);
+  inputs.push_back(editTokens(i_tokens, i_tokens.size()/4, CheckEdit::REPEAT));
+  inputs.push_back(editTokens(i_tokens, 3*i_tokens.size()/4, CheckEdit::DELETE));
+
+  std::string detail;
+  for(LRTable::Type const type : {LRTable::Type::LR, LRTable::Type::LALR})
+  {
+    LRParser parser(type, 1, g);
+    parser.addSplitToken(i_benchCase.splitToken());
+    parser.setRecovery(LRParser::Recovery::REPAIR);
+    for(LRParser::UnitRules const unitRules : {LRParser::UnitRules::KEEP, LRParser::UnitRules::BYPASS})
+    {
+      parser.setUnitRules(unitRules);
+      for(size_t i=0; i<inputs.size() && detail.empty(); ++i)
+      {
+        CheckRun const parseRun=parseTokens(parser, inputs[i]);
+        CheckRun outcomeRun(parseRun);
+        outcomeRun.steps.clear();
+        for(size_t const threadCount : {2, 4})
+        {
+          detail = compareRuns(parseRun, parallelTokens(parser, inputs[i], threadCount, true));
+          if(detail.empty())
+          {
+            detail = compareRuns(outcomeRun, parallelTokens(parser, inputs[i], threadCount, false));
+          }
+          if(!detail.empty())
+          {
+            detail = "type "+std::to_string(static_cast<int>(type))+", unit rules "+std::to_string(static_cast<int>(unitRules))+", input "+std::to_string(i)
+              +", "+std::to_string(threadCount)+" threads: "+detail;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  report("parallel", i_benchCase.name(), detail.empty(), detail);
+}
+/**************************************************/
+
+int main(int const argc, char const * const * const argv)
+{
+  std::string directory="/tmp";
+  for(int i=1; i<argc; ++i)
+  {
+    if(strcmp(argv[i], "--directory") == 0 && i+1 < argc)
+    {
+      directory = argv[++i];
+    }
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  for(BenchCase const &benchCase : benchCases())
+  {
+    SymbolStack const tokens=writeTokens(benchCase, directory, 16384);
+    checkUpdate(benchCase, tokens);
+    checkRebuild(benchCase, tokens);
+    checkRecovery(benchCase, tokens);
+    checkPush(benchCase, tokens);
+    checkParallel(benchCase, tokens);
+  }
+
+  checkPrecedence();
+
+  std::cout << s_checkCount << " checks, " << s_failureCount << " failed" << std::endl;
+  return (s_failureCount == 0) ? 0 : 1;
+}
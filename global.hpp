@@ -13,7 +13,7 @@ constexpr typename std::underlying_type<T>::type enum_value(T val)
 
 #define ENUM_GENERATE_HELPERS(x)  \
   inline x operator|=(x &i_a, x const i_b){return (i_a = static_cast<x>(enum_value(i_a)|enum_value(i_b)));} \
-  inline x operator&=(x &i_a, x const i_b){return (i_a = static_cast<x>(enum_value(i_a)|enum_value(i_b)));} \
+  inline x operator&=(x &i_a, x const i_b){return (i_a = static_cast<x>(enum_value(i_a)&enum_value(i_b)));} \
   inline x operator~(x const i_a){return static_cast<x>(~enum_value(i_a));}                              \
   inline x operator|(x const i_a, x const i_b){return static_cast<x>(enum_value(i_a)|enum_value(i_b));}  \
   inline x operator&(x const i_a, x const i_b){return static_cast<x>(enum_value(i_a)&enum_value(i_b));}  \
@@ -1,10 +1,13 @@
 #include "LRParser.hpp"
+#include "CompiledGrammar.hpp"
 #include "Grammar.hpp"
 #include "Production.hpp"
 #include "Symbol.hpp"
 #include "LexText.hpp"
+#include "LRTrace.hpp"
 
 #include <iostream>
+#include <sstream>
 
 std::string const TEST_FILEPATH="testLex.txt";
 
@@ -43,16 +46,27 @@ int main(int const argc, char const * const * const argv)
   g |= NT("expr") >>= NT("expr") + T("+") + NT("expr");
   */
 
-  LRParser p(LRTable::Type::LR, 1, g);
+  CompiledGrammar const compiled=g.freeze();
+  LRParser p(LRTable::Type::LR, 1, compiled);
   LexText plt(TEST_FILEPATH);
 #ifndef NDEBUG
   std::cout << "====================----- Parsing -----====================" << std::endl;
 #endif
+#ifndef NDEBUG
+  LRTrace trace(compiled);
+  ParseSession session;
+  session.setTrace(&trace);
+  if(p.parse(plt, session))
+#else
   if(p.parse(plt))
+#endif
   {
     std::cout << "Parsing success." << std::endl;
   }
 #ifndef NDEBUG
+  std::stringstream traceStream;
+  trace.write(traceStream);
+  LRTrace::decode(traceStream, std::cout);
   std::cout << "==================================================" << std::endl;
 #endif
 
@@ -0,0 +1,34 @@
+#include "LRTrace.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+//Decodes traces written by LRTrace::save() into one line per parser step
+int main(int const argc, char const * const * const argv)
+{
+  if(argc != 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " TRACE_FILE" << std::endl;
+    return 1;
+  }
+
+  std::ifstream input(argv[1], std::ios::binary);
+  if(!input)
+  {
+    std::cerr << "Unable to open " << argv[1] << std::endl;
+    return 1;
+  }
+
+  try
+  {
+    LRTrace::decode(input, std::cout);
+  }
+  catch(std::runtime_error const &e)
+  {
+    std::cerr << argv[1] << ": " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}